@@ -0,0 +1,440 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+#include "AudioContext.h"
+#include "BandMapper.h"
+#include "BeatDetector.h"
+#include "Decimator.h"
+#include "Percussion.h"
+#include "RingBuffer.h"
+#include "SpectrumEngine.h"
+#include "TempoTracker.h"
+
+// The hop-driven analysis chain: sample ring -> spectrum engines -> band mapping -> normalization
+// and smoothing -> beat tracking -> AudioContext. The spectrum is multi-rate: a decimated copy of the
+// input feeds a long low-band FFT for fine bass resolution, a short full-rate FFT keeps the highs
+// responsive, and the band mapper reads each band from whichever one covers it. The analyzer
+// also keeps the waveform and spectrogram history that contexts hand out views of, so it must outlive
+// them. It owns no hardware, thread or RTOS handle, so the same chain runs on the MicFFT thread and
+// offline against any AudioSource, e.g.
+//
+//     while ((n = source.read(hop.data(), hop.size(), 0)) > 0)
+//         analyzer.process(hop.data(), n, 0, context);
+class AudioAnalyzer final
+{
+  public:
+    static constexpr size_t SAMPLE_RATE = 22050;
+    static constexpr float BAND_MIN_HZ = 40.0f;
+    static constexpr float BAND_MAX_HZ = SAMPLE_RATE / 2.0f;
+
+    // Short full-rate FFT for the highs: 86 Hz bins over the last 12 ms
+    static constexpr size_t HIGH_BUFFER_SIZE = 256;
+    static constexpr size_t HIGH_SPECTRUM_SIZE = SpectrumEngine<HIGH_BUFFER_SIZE>::SPECTRUM_SIZE;
+    static constexpr float HIGH_BIN_HZ = static_cast<float>(SAMPLE_RATE) / HIGH_BUFFER_SIZE;
+
+    // Long FFT over the input decimated to 2756 Hz: 11 Hz bins over the last 93 ms
+    static constexpr size_t LOW_DECIMATION = 8;
+    static constexpr size_t LOW_DECIMATOR_TAPS = 16 * LOW_DECIMATION;
+    static constexpr size_t LOW_BUFFER_SIZE = 256;
+    static constexpr size_t LOW_SPECTRUM_SIZE = SpectrumEngine<LOW_BUFFER_SIZE>::SPECTRUM_SIZE;
+    static constexpr float LOW_BIN_HZ = static_cast<float>(SAMPLE_RATE) / (LOW_DECIMATION * LOW_BUFFER_SIZE);
+
+    // Bands centered below this read the low FFT; the decimator is flat up to ~73% of its Nyquist
+    static constexpr float CROSSOVER_HZ = 1000.0f;
+
+    // Both spectra laid end to end, low first, as the band mapper reads them
+    static constexpr size_t SPECTRUM_SIZE = LOW_SPECTRUM_SIZE + HIGH_SPECTRUM_SIZE;
+
+    // Waveform history: boxcar-averaged groups of WAVEFORM_DECIMATION samples, a scope trace rather than audio
+    static constexpr size_t WAVEFORM_DECIMATION = 4;
+    static constexpr float WAVEFORM_RATE = static_cast<float>(SAMPLE_RATE) / WAVEFORM_DECIMATION;
+
+    // Smallest and largest hop the analysis is sized for. A hop longer than the high window would skip
+    // samples between windows.
+    static constexpr size_t HOP_SIZE_MIN = 64;
+    static constexpr size_t HOP_SIZE_MAX = HIGH_BUFFER_SIZE;
+    static constexpr size_t HOP_SIZE_DEFAULT = 128;
+
+    // Longest beat period in analysis frames, at TEMPO_MIN_BPM and the smallest hop
+    static constexpr size_t TEMPO_MAX_LAG =
+        static_cast<size_t>(60.0f * SAMPLE_RATE / (TEMPO_MIN_BPM * HOP_SIZE_MIN)) + 1;
+
+    // Smoothing and peak constants below are per frame at this frame period and get rescaled to the hop
+    static constexpr float SMOOTHING_REFERENCE_MS = 30.0f;
+
+    static constexpr float PEAK_HOLD_TIME = 3.0f;
+    static constexpr float BAND_NORM_FACTOR = 0.995f;
+    static constexpr float LOG_SCALE_BASE = SPECTRUM_LOG_SCALE_BASE;
+    static constexpr float ENERGY_ATTACK_FACTOR = 10.0f;
+    static constexpr float ENERGY_ATTACK_MIN = 0.2f;
+    static constexpr float ENERGY_ATTACK_MAX = 0.9f;
+    static constexpr float ENERGY_DECAY_FACTOR = 0.15f;
+    static constexpr float ENERGY_DECAY_MIN = 0.6f;
+    static constexpr float ENERGY_DECAY_MAX = 0.95f;
+
+    // Onset group weights of the tempo envelope, lowest band group first
+    static constexpr std::array<float, BeatDetector::Onsets::GROUPS> TEMPO_GROUP_WEIGHTS = {1.0f, 0.4f, 0.15f, 0.05f};
+
+    // Microsecond clock used for the analysis timestamps; may be null
+    using ClockFn = uint32_t (*)();
+
+  private:
+    ClockFn clock_;
+
+    RingBuffer<int32_t, HIGH_BUFFER_SIZE> sampleRing_;
+    std::array<int32_t, HIGH_BUFFER_SIZE> frame_{};
+    SpectrumEngine<HIGH_BUFFER_SIZE> spectrumEngine_;
+
+    Decimator<LOW_DECIMATION, LOW_DECIMATOR_TAPS> decimator_;
+    std::array<int32_t, HOP_SIZE_MAX / LOW_DECIMATION + 1> decimated_{};
+    RingBuffer<int32_t, LOW_BUFFER_SIZE> lowRing_;
+    std::array<int32_t, LOW_BUFFER_SIZE> lowFrame_{};
+    SpectrumEngine<LOW_BUFFER_SIZE> lowSpectrumEngine_;
+
+    BandMapper<BINS, SPECTRUM_SIZE> bandMapper_;
+    std::array<float, SPECTRUM_SIZE> binLevels_{};
+
+    AudioContext::Waveform waveform_;
+    AudioContext::Spectrogram spectrogram_;
+    int32_t waveformSum_ = 0;
+    size_t waveformCount_ = 0;
+
+    std::atomic<WindowType> windowType_{WindowType::HANN};
+    std::atomic<BandScale> bandScale_{BandScale::MEL};
+    BandScale appliedBandScale_ = BandScale::MEL;
+
+    // Per-frame coefficients for the configured hop, see SMOOTHING_REFERENCE_MS
+    std::atomic<size_t> hopSize_{HOP_SIZE_DEFAULT};
+    size_t hop_ = 0;
+    float frameScale_ = 1.0f;
+    float bandNormFactor_ = BAND_NORM_FACTOR;
+    float peakDecay_ = 0.9f;
+
+    std::array<float, BINS> lastSpectrum_{};
+    std::array<float, BINS> peakLevels_{};
+    std::array<float, BINS> peakHoldCounters_{};
+    std::array<float, BINS> bandMaxHistory_{};
+
+    float dynAttack_ = 1.0f;
+    float dynDecay_ = 1.0f;
+    uint32_t totalBeats_ = 0;
+
+    // First bands of the mid and high feature ranges, on the percussion splits
+    uint8_t midBand_ = 0;
+    uint8_t highBand_ = 0;
+
+    // Samples analysed so far; the audio clock all beat and onset timing is derived from
+    uint64_t sampleClock_ = 0;
+
+    BeatDetector beatDetector_;
+    TempoTracker<TEMPO_MAX_LAG> tempoTracker_;
+    PercussionClassifier percussion_;
+
+  public:
+    explicit AudioAnalyzer(const ClockFn clock = nullptr)
+        : clock_(clock)
+    {
+        configureBands(appliedBandScale_);
+    }
+
+    // Safe to call from any thread; takes effect on the next frame
+    void setWindow(const WindowType type)
+    {
+        windowType_.store(type);
+    }
+
+    [[nodiscard]] WindowType getWindow() const
+    {
+        return windowType_.load();
+    }
+
+    // Safe to call from any thread; the band table is rebuilt on the analysing thread
+    void setBandScale(const BandScale scale)
+    {
+        bandScale_.store(scale);
+    }
+
+    [[nodiscard]] BandScale getBandScale() const
+    {
+        return bandScale_.load();
+    }
+
+    // Safe to call from any thread; the per-frame coefficients and the tempo tracker are rescaled on
+    // the analysing thread. `hop` must be within HOP_SIZE_MIN to HOP_SIZE_MAX.
+    void setHopSize(const size_t hop)
+    {
+        hopSize_.store(hop);
+    }
+
+    [[nodiscard]] size_t getHopSize() const
+    {
+        return hopSize_.load();
+    }
+
+    // Appends `count` newly captured samples (32-bit I2S words, at most HOP_SIZE_MAX) and analyses
+    // the trailing low and high windows into `audio`. Calls normally carry one hop of samples; a short
+    // read is analysed with the configured hop's coefficients, so it does not reset the tempo tracker.
+    void process(const int32_t *samples, const size_t count, const uint32_t captureUs, AudioContext &audio)
+    {
+        if (const size_t hop = hopSize_.load(); hop != hop_)
+        {
+            hop_ = hop;
+            frameScale_ = static_cast<float>(hop_) * 1000.0f / (SAMPLE_RATE * SMOOTHING_REFERENCE_MS);
+            bandNormFactor_ = std::pow(BAND_NORM_FACTOR, frameScale_);
+            peakDecay_ = std::pow(0.9f, frameScale_);
+            tempoTracker_.configure(static_cast<float>(hop_) / SAMPLE_RATE);
+        }
+
+        // Slide the analysis window forward by the new samples
+        sampleRing_.push(samples, count);
+        sampleClock_ += count;
+        appendWaveform(samples, count);
+        const uint32_t audioTimeMs = static_cast<uint32_t>(sampleClock_ * 1000 / SAMPLE_RATE);
+
+        // Rebuild the band table when a new band scale was requested
+        if (const BandScale scale = bandScale_.load(); scale != appliedBandScale_)
+        {
+            appliedBandScale_ = scale;
+            configureBands(scale);
+        }
+
+        std::array<float, BINS> spectrum{};
+        std::array<float, BINS> heights{};
+        std::array<float, BINS> peaks{};
+
+        sampleRing_.copyTo(frame_.data());
+        const size_t decimated = decimator_.process(samples, count, decimated_.data());
+        lowRing_.push(decimated_.data(), decimated);
+        lowRing_.copyTo(lowFrame_.data());
+
+        // Window, FFT, magnitude and logarithmic scaling (float or Q15, chosen at compile time), only
+        // up to the bins the band table reads from each spectrum
+        const WindowType window = windowType_.load();
+        float *highLevels = binLevels_.data() + LOW_SPECTRUM_SIZE;
+        lowSpectrumEngine_.process(window, lowFrame_.data(), binLevels_.data(), bandMapper_.usedBins(0));
+        spectrumEngine_.process(window, frame_.data(), highLevels, bandMapper_.usedBins(1));
+
+        // Fold the FFT bins into BINS bands
+        bandMapper_.map(binLevels_.data(), spectrum.data());
+
+        const uint32_t analyzedUs = clock_ ? clock_() : 0;
+
+        float energy = 0;
+
+        // Per-band normalization
+        for (size_t i = 0; i < BINS; ++i)
+        {
+            // Update band max history and normalize
+            bandMaxHistory_[i] = std::max(bandMaxHistory_[i] * bandNormFactor_, spectrum[i]);
+            const float normFactor = std::max(0.01f, bandMaxHistory_[i]);
+            spectrum[i] = spectrum[i] / normFactor;
+
+            // Scale to matrix height
+            spectrum[i] *= BINS - 1;
+            energy += spectrum[i];
+        }
+
+        energy /= BINS;
+        dynAttack_ = 1.0f + energy * ENERGY_ATTACK_FACTOR;
+        dynDecay_ = 1.0f - energy * ENERGY_DECAY_FACTOR;
+        dynAttack_ = std::min(std::max(dynAttack_, ENERGY_ATTACK_MIN), ENERGY_ATTACK_MAX);
+        dynDecay_ = std::min(std::max(dynDecay_, ENERGY_DECAY_MIN), ENERGY_DECAY_MAX);
+
+        // Same response per unit of time regardless of how many frames the hop produces
+        dynAttack_ = 1.0f - std::pow(1.0f - dynAttack_, frameScale_);
+        dynDecay_ = std::pow(dynDecay_, frameScale_);
+
+        energy = 0;
+        float energyPeaks = 0;
+
+        for (uint8_t x = 0; x < BINS; ++x)
+        {
+            if (const float currentValue = spectrum[x]; currentValue > lastSpectrum_[x])
+            {
+                lastSpectrum_[x] = lastSpectrum_[x] * (1.0f - dynAttack_) + currentValue * dynAttack_;
+            }
+            else
+            {
+                lastSpectrum_[x] = lastSpectrum_[x] * dynDecay_ + currentValue * (1.0f - dynDecay_);
+            }
+
+            if (lastSpectrum_[x] > peakLevels_[x])
+            {
+                peakLevels_[x] = lastSpectrum_[x];
+                peakHoldCounters_[x] = PEAK_HOLD_TIME;
+            }
+            else
+            {
+                if (peakHoldCounters_[x] > 0)
+                {
+                    peakHoldCounters_[x] -= frameScale_;
+                }
+                else
+                {
+                    peakLevels_[x] *= peakDecay_;
+                }
+            }
+
+            heights[x] = std::min(lastSpectrum_[x], static_cast<float>(BINS));
+            energy += heights[x];
+            peaks[x] = std::min(peakLevels_[x], static_cast<float>(BINS));
+            energyPeaks += peaks[x];
+        }
+
+        energy /= BINS;
+        energyPeaks /= BINS;
+
+        // Beat tracking runs once per analysis frame, on the unsmoothed bands so attacks stay sharp
+        beatDetector_.update(spectrum, audioTimeMs);
+        if (beatDetector_.isBeatDetected())
+            totalBeats_++;
+
+        // Per-band normalization makes broadband hats dominate the full-band flux, so the tempo
+        // envelope leans on the low groups where kicks and downbeats live
+        const auto &onsets = beatDetector_.getOnsets();
+        float envelope = 0.0f;
+        for (size_t g = 0; g < onsets.GROUPS; ++g)
+        {
+            envelope += TEMPO_GROUP_WEIGHTS[g] * onsets.flux(g);
+        }
+        tempoTracker_.update(envelope);
+        percussion_.update(onsets);
+
+        buildContext(audio, heights, peaks, energy, energyPeaks);
+        spectrogram_.push(audio.heights8);
+        audio.waveform = waveform_.view();
+        audio.spectrogram = spectrogram_.view();
+        audio.audioTimeMs = audioTimeMs;
+        audio.timestamps.captureUs = captureUs;
+        audio.timestamps.analyzedUs = analyzedUs;
+        audio.nextBeatUs = captureUs + static_cast<uint32_t>(tempoTracker_.secondsToNextBeat() * 1e6f);
+    }
+
+  private:
+    // Lays the band mapping out and puts the onset groups on the percussion ranges
+    void configureBands(const BandScale scale)
+    {
+        using Segment = decltype(bandMapper_)::Segment;
+        const std::array<Segment, 2> segments = {
+            Segment{LOW_BIN_HZ, 0, LOW_SPECTRUM_SIZE, CROSSOVER_HZ},
+            Segment{HIGH_BIN_HZ, LOW_SPECTRUM_SIZE, HIGH_SPECTRUM_SIZE, BAND_MAX_HZ},
+        };
+        bandMapper_.configure(scale, segments.data(), segments.size(), BAND_MIN_HZ, BAND_MAX_HZ);
+
+        BeatDetector::Onsets::GroupEdges edges{};
+        for (size_t g = 1; g < edges.size() - 1; ++g)
+        {
+            const size_t band = bandMapper_.bandAt(PERCUSSION_SPLIT_HZ[g - 1]);
+            edges[g] = std::clamp(band, edges[g - 1] + 1, BINS - (edges.size() - 1 - g));
+        }
+        edges.back() = BINS;
+        beatDetector_.setOnsetGroups(edges);
+
+        midBand_ = static_cast<uint8_t>(edges[1]);
+        highBand_ = static_cast<uint8_t>(edges[2]);
+    }
+
+    void appendWaveform(const int32_t *samples, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            waveformSum_ += samples[i] >> 16;
+            if (++waveformCount_ < WAVEFORM_DECIMATION)
+                continue;
+
+            waveform_.push(static_cast<int16_t>(waveformSum_ / static_cast<int32_t>(WAVEFORM_DECIMATION)));
+            waveformSum_ = 0;
+            waveformCount_ = 0;
+        }
+    }
+
+    // Spectrum shape of the smoothed heights; the range sums read the prefix sums, so those come first
+    void buildFeatures(AudioContext &audio, const std::array<float, BINS> &heights) const
+    {
+        // Keeps silent bands out of log(0) and an all-silent spectrum at flatness 1
+        constexpr float floor = 1e-3f;
+
+        float total = 0.0f;
+        float weighted = 0.0f;
+        float logSum = 0.0f;
+        for (size_t i = 0; i < BINS; ++i)
+        {
+            total += heights[i];
+            weighted += heights[i] * static_cast<float>(i);
+            logSum += std::log(heights[i] + floor);
+        }
+
+        const float threshold = total * AudioFeatures::ROLLOFF_FRACTION;
+        float running = heights[0];
+        size_t rolloff = 0;
+        while (rolloff < BINS - 1 && running < threshold)
+            running += heights[++rolloff];
+
+        AudioFeatures &features = audio.features;
+        features.centroid = total > 0.0f ? weighted / (total * (BINS - 1)) : 0.0f;
+        features.flatness = std::min(1.0f, std::exp(logSum / BINS) / (total / BINS + floor));
+        features.flux = beatDetector_.getOnsets().flux();
+        features.rolloff = static_cast<uint8_t>(rolloff);
+
+        features.midBand = midBand_;
+        features.highBand = highBand_;
+        features.lowSum = audio.sumHeights8Range(0, midBand_);
+        features.midSum = audio.sumHeights8Range(midBand_, highBand_);
+        features.highSum = audio.sumHeights8Range(highBand_, BINS);
+    }
+
+    void buildContext(
+        AudioContext &audio,
+        const std::array<float, BINS> &heights,
+        const std::array<float, BINS> &peaks,
+        const float energy,
+        const float energyPeaks) const
+    {
+        // Heights and peaks span 0-63, the 8-bit views span 0-255
+        constexpr float to8 = 255.0f / 63.0f;
+
+        audio.heights8Sums[0] = 0;
+        audio.peaks8Sums[0] = 0;
+        for (size_t i = 0; i < BINS; ++i)
+        {
+            audio.heights8[i] = static_cast<uint8_t>(std::min(255.0f, heights[i] * to8));
+            audio.peaks8[i] = static_cast<uint8_t>(std::min(255.0f, peaks[i] * to8));
+            audio.heights8Sums[i + 1] = audio.heights8Sums[i] + audio.heights8[i];
+            audio.peaks8Sums[i + 1] = audio.peaks8Sums[i] + audio.peaks8[i];
+        }
+
+        buildFeatures(audio, heights);
+
+        audio.isBeat = beatDetector_.isBeatDetected();
+        audio.totalBeats = totalBeats_;
+        audio.lastBeatMs = beatDetector_.getLastBeatTime();
+
+        audio.kick = percussion_.event(Percussion::KICK);
+        audio.snare = percussion_.event(Percussion::SNARE);
+        audio.hat = percussion_.event(Percussion::HAT);
+
+        audio.beatPhase = tempoTracker_.phase();
+        audio.beatPeriodUs = static_cast<uint32_t>(tempoTracker_.periodSeconds() * 1e6f);
+        audio.clockBeats = tempoTracker_.beats();
+        audio.tempoConfidence = tempoTracker_.confidence();
+
+        // Interval BPM until the tempo tracker locks
+        const float bpm = audio.tempoLocked() ? tempoTracker_.bpm() : beatDetector_.getBPM();
+        audio.bpm = static_cast<uint16_t>(bpm + 0.5f);
+
+        audio.energy64f = energy;
+        audio.energy64fScaled = std::min(63.0f, 1.5f * energy);
+        audio.energy8 = std::min(255.0f, energy * to8);
+        audio.energy8Scaled = std::min(255.0f, 1.5f * energy * to8);
+
+        audio.energy64fPeaks = energyPeaks;
+        audio.energy64fPeaksScaled = std::min(63.0f, 1.5f * energyPeaks);
+        audio.energy8Peaks = std::min(255.0f, energyPeaks * to8);
+        audio.energy8PeaksScaled = std::min(255.0f, 1.5f * energyPeaks * to8);
+    }
+};
@@ -0,0 +1,156 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+#include "HistoryRing.h"
+#include "LatencyStats.h"
+#include "Percussion.h"
+
+// Spectrum shape and range sums over the smoothed bands, computed once per analysis frame so
+// patterns read them instead of recomputing them every render
+struct AudioFeatures
+{
+    // Share of the height sum that lies at or below the rolloff band
+    static constexpr float ROLLOFF_FRACTION = 0.85f;
+
+    float centroid;   // Height-weighted mean band, 0 at the lowest band to 1 at the highest
+    float flatness;   // Geometric over arithmetic mean of the heights, near 0 for a single tone, 1 when flat
+    float flux;       // Mean rise per band since the previous frame, in 0-63 band units
+    uint8_t rolloff;  // Lowest band at which ROLLOFF_FRACTION of the height sum is reached
+
+    // heights8 summed over the low (below PERCUSSION_SPLIT_HZ[0]), mid (up to PERCUSSION_SPLIT_HZ[1])
+    // and high ranges, which start at midBand and highBand
+    uint16_t lowSum;
+    uint16_t midSum;
+    uint16_t highSum;
+    uint8_t midBand;
+    uint8_t highBand;
+};
+
+struct AudioContext
+{
+    // Tempo tracker confidence from which bpm and the beat clock follow the tracker
+    static constexpr float TEMPO_LOCK_CONFIDENCE = 0.5f;
+
+    // History kept by the analyzer: ~93 ms of waveform at AudioAnalyzer::WAVEFORM_RATE and the
+    // heights8 of the last 64 analysis frames
+    static constexpr size_t WAVEFORM_SIZE = 512;
+    static constexpr size_t SPECTROGRAM_FRAMES = 64;
+
+    using Waveform = HistoryRing<int16_t, WAVEFORM_SIZE>;
+    using Spectrogram = HistoryRing<std::array<uint8_t, BINS>, SPECTROGRAM_FRAMES>;
+
+    std::array<uint8_t, BINS> heights8;
+    std::array<uint8_t, BINS> peaks8;
+
+    // Prefix sums, element i holds the sum of bands [0, i), so any range sum is two reads
+    std::array<uint16_t, BINS + 1> heights8Sums;
+    std::array<uint16_t, BINS + 1> peaks8Sums;
+    AudioFeatures features;
+
+    // Views into the analyzer's history as of this frame, newest first: decimated 16-bit samples and
+    // heights8 rows. Empty until the analyzer publishes; see HistoryView for reading them while it runs.
+    Waveform::View waveform;
+    Spectrogram::View spectrogram;
+
+    uint16_t bpm;
+    bool isBeat;
+    uint32_t totalBeats;
+    uint32_t audioTimeMs; // Sample clock at the end of this frame
+    uint32_t lastBeatMs;  // Sample clock at the last detected beat
+    float energy64f;
+    float energy64fScaled;
+    uint8_t energy8;
+    uint8_t energy8Scaled;
+    float energy64fPeaks;
+    float energy64fPeaksScaled;
+    uint8_t energy8Peaks;
+    uint8_t energy8PeaksScaled;
+    AudioTimestamps timestamps;
+
+    // Percussive onsets by range; hit is sticky across analysis frames like isBeat
+    PercussiveEvent kick;
+    PercussiveEvent snare;
+    PercussiveEvent hat;
+
+    // Predictive beat clock, referenced to timestamps.captureUs
+    float beatPhase;        // 0-1 through the current beat
+    uint32_t beatPeriodUs;  // Current beat period
+    uint32_t nextBeatUs;    // Predicted time of the next beat (esp_timer clock)
+    uint32_t clockBeats;    // Beats completed by the clock
+    float tempoConfidence;  // 0-1, see TEMPO_LOCK_CONFIDENCE
+
+    [[nodiscard]] bool tempoLocked() const
+    {
+        return tempoConfidence >= TEMPO_LOCK_CONFIDENCE;
+    }
+
+    // Beat phase extrapolated to `nowUs`, so renders land on the beat despite analysis latency
+    [[nodiscard]] float beatPhaseAt(const uint32_t nowUs) const
+    {
+        if (!beatPeriodUs)
+            return beatPhase;
+
+        const float beats = beatPhase + static_cast<float>(nowUs - timestamps.captureUs) / beatPeriodUs;
+        return beats - std::floor(beats);
+    }
+
+    // Clock beats completed at `nowUs`, extrapolated the same way
+    [[nodiscard]] uint32_t clockBeatsAt(const uint32_t nowUs) const
+    {
+        if (!beatPeriodUs)
+            return clockBeats;
+
+        const float elapsed = static_cast<float>(nowUs - timestamps.captureUs) / beatPeriodUs;
+        return clockBeats + static_cast<uint32_t>(beatPhase + elapsed);
+    }
+
+    // Largest magnitude among the newest `count` waveform samples, at least `floor`
+    [[nodiscard]] int32_t waveformPeak(const size_t count, const int32_t floor = 1) const
+    {
+        int32_t peak = floor;
+        int16_t sample;
+        for (size_t i = 0; i < count && waveform.read(i, sample); ++i)
+            peak = std::max(peak, std::abs(static_cast<int32_t>(sample)));
+        return peak;
+    }
+
+    // Sum of heights8 over bands [low, high)
+    [[nodiscard]] uint16_t sumHeights8Range(const uint8_t low, const uint8_t high) const
+    {
+        return rangeSum(heights8Sums, low, high);
+    }
+
+    [[nodiscard]] uint16_t sumPeaks8Range(const uint8_t low, const uint8_t high) const
+    {
+        return rangeSum(peaks8Sums, low, high);
+    }
+
+    // Mean of heights8 over bands [low, high)
+    [[nodiscard]] uint8_t avgHeights8Range(const uint8_t low, const uint8_t high) const
+    {
+        return rangeAverage(heights8Sums, low, high);
+    }
+
+    [[nodiscard]] uint8_t avgPeaks8Range(const uint8_t low, const uint8_t high) const
+    {
+        return rangeAverage(peaks8Sums, low, high);
+    }
+
+  private:
+    static uint16_t rangeSum(const std::array<uint16_t, BINS + 1> &sums, const uint8_t low, uint8_t high)
+    {
+        high = std::min<uint8_t>(high, BINS);
+        return high > low ? sums[high] - sums[low] : 0;
+    }
+
+    static uint8_t rangeAverage(const std::array<uint16_t, BINS + 1> &sums, const uint8_t low, uint8_t high)
+    {
+        high = std::min<uint8_t>(high, BINS);
+        return high > low ? (sums[high] - sums[low]) / (high - low) : 0;
+    }
+};
@@ -0,0 +1,351 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <utility>
+
+// Where the analysis chain gets its samples from. Samples are delivered as mono 32-bit words
+// with the audio in the upper 16 bits, the same layout the I2S microphone produces.
+class AudioSource
+{
+    bool realtime_ = false;
+    std::chrono::steady_clock::time_point nextDeadline_{};
+
+  protected:
+    // Sleeps until `count` samples' worth of real time has passed since the previous call,
+    // so file and generated sources can stand in for the microphone on the device.
+    void pace(const size_t count, const uint32_t sampleRate)
+    {
+        if (!realtime_)
+            return;
+
+        const auto now = std::chrono::steady_clock::now();
+        if (nextDeadline_ < now - std::chrono::milliseconds(100))
+        {
+            nextDeadline_ = now;
+        }
+
+        nextDeadline_ += std::chrono::microseconds(count * 1000000ull / sampleRate);
+        std::this_thread::sleep_until(nextDeadline_);
+    }
+
+  public:
+    virtual ~AudioSource() = default;
+
+    virtual bool begin() = 0;
+    virtual void end() = 0;
+
+    // Reads up to `count` samples, waiting at most timeoutMs for them; returns the number read
+    virtual size_t read(int32_t *samples, size_t count, uint32_t timeoutMs) = 0;
+
+    [[nodiscard]] virtual uint32_t sampleRate() const = 0;
+
+    // Real-time sources pace reads to the sample rate instead of returning as fast as possible
+    void setRealtime(const bool realtime)
+    {
+        realtime_ = realtime;
+    }
+};
+
+// Test signal generator: optional sine tones, a kick drum on a fixed tempo with an optional
+// backbeat snare, hi-hat noise bursts on the off-beats, and a white noise floor. Amplitudes are 0-1 of full scale.
+class SyntheticAudioSource final : public AudioSource
+{
+  public:
+    static constexpr size_t MAX_TONES = 4;
+    static constexpr float TWO_PI = 2.0f * static_cast<float>(M_PI);
+
+    struct Tone
+    {
+        float hz;
+        float amplitude;
+    };
+
+  private:
+    uint32_t sampleRate_;
+    std::array<Tone, MAX_TONES> tones_{};
+    std::array<float, MAX_TONES> phases_{};
+    size_t toneCount_ = 0;
+
+    float bpm_ = 0.0f;
+    float kickAmplitude_ = 0.0f;
+    float snareAmplitude_ = 0.0f;
+    float hatAmplitude_ = 0.0f;
+    float noiseAmplitude_ = 0.0f;
+
+    uint64_t position_ = 0;
+    uint32_t noiseState_ = 0x12345678;
+    float lastHatNoise_ = 0.0f;
+
+    float noise()
+    {
+        // xorshift32, mapped to [-1, 1)
+        noiseState_ ^= noiseState_ << 13;
+        noiseState_ ^= noiseState_ >> 17;
+        noiseState_ ^= noiseState_ << 5;
+        return static_cast<float>(static_cast<int32_t>(noiseState_)) / 2147483648.0f;
+    }
+
+  public:
+    explicit SyntheticAudioSource(const uint32_t sampleRate)
+        : sampleRate_(sampleRate)
+    {
+    }
+
+    bool addTone(const float hz, const float amplitude)
+    {
+        if (toneCount_ >= MAX_TONES)
+            return false;
+
+        tones_[toneCount_++] = {hz, amplitude};
+        return true;
+    }
+
+    void setBeat(const float bpm, const float kickAmplitude, const float hatAmplitude)
+    {
+        bpm_ = bpm;
+        kickAmplitude_ = kickAmplitude;
+        hatAmplitude_ = hatAmplitude;
+    }
+
+    // Snare on every second beat, i.e. the backbeat
+    void setSnare(const float amplitude)
+    {
+        snareAmplitude_ = amplitude;
+    }
+
+    void setNoise(const float amplitude)
+    {
+        noiseAmplitude_ = amplitude;
+    }
+
+    bool begin() override
+    {
+        position_ = 0;
+        phases_.fill(0.0f);
+        lastHatNoise_ = 0.0f;
+        return true;
+    }
+
+    void end() override
+    {
+    }
+
+    size_t read(int32_t *samples, const size_t count, const uint32_t timeoutMs) override
+    {
+        const float rate = static_cast<float>(sampleRate_);
+        const uint64_t beatLength = bpm_ > 0.0f ? static_cast<uint64_t>(rate * 60.0f / bpm_) : 0;
+
+        for (size_t i = 0; i < count; ++i, ++position_)
+        {
+            float value = noiseAmplitude_ * noise();
+
+            for (size_t t = 0; t < toneCount_; ++t)
+            {
+                value += tones_[t].amplitude * std::sin(phases_[t]);
+                phases_[t] = std::fmod(phases_[t] + TWO_PI * tones_[t].hz / rate, TWO_PI);
+            }
+
+            if (beatLength > 0)
+            {
+                const float sinceBeat = static_cast<float>(position_ % beatLength) / rate;
+                const float sinceOffBeat = static_cast<float>((position_ + beatLength / 2) % beatLength) / rate;
+
+                // Kick: pitch-dropping sine with a fast decay; hat: short burst of differenced
+                // (high-passed) noise
+                const float kickHz = 50.0f + 100.0f * std::exp(-sinceBeat * 40.0f);
+                value += kickAmplitude_ * std::exp(-sinceBeat * 30.0f) * std::sin(TWO_PI * kickHz * sinceBeat);
+
+                if (snareAmplitude_ > 0.0f && (position_ / beatLength) % 2 == 1)
+                {
+                    // Snare: short 180 Hz body plus a broadband noise burst
+                    value += snareAmplitude_ * std::exp(-sinceBeat * 40.0f) *
+                             (0.5f * std::sin(TWO_PI * 180.0f * sinceBeat) + 0.5f * noise());
+                }
+
+                const float hatNoise = noise();
+                value += 0.5f * hatAmplitude_ * std::exp(-sinceOffBeat * 200.0f) * (hatNoise - lastHatNoise_);
+                lastHatNoise_ = hatNoise;
+            }
+
+            value = std::fmax(-1.0f, std::fmin(value, 32767.0f / 32768.0f));
+            samples[i] = static_cast<int32_t>(value * 32768.0f) << 16;
+        }
+
+        pace(count, sampleRate_);
+        return count;
+    }
+
+    [[nodiscard]] uint32_t sampleRate() const override
+    {
+        return sampleRate_;
+    }
+};
+
+// Replays 16/24/32-bit integer PCM from a WAV file, or headerless 16-bit mono PCM at a given rate.
+// Multi-channel files are reduced to their first channel. Reaching the end either loops or ends the stream.
+class PcmFileAudioSource final : public AudioSource
+{
+    std::string path_;
+    bool loop_;
+    FILE *file_ = nullptr;
+
+    uint32_t sampleRate_;
+    uint16_t channels_ = 1;
+    uint16_t bytesPerSample_ = 2;
+    long dataStart_ = 0;
+    long dataEnd_ = 0;
+
+    static uint32_t readLe(const uint8_t *bytes, const size_t size)
+    {
+        uint32_t value = 0;
+        for (size_t i = 0; i < size; ++i)
+        {
+            value |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+        }
+        return value;
+    }
+
+    bool parseWavHeader()
+    {
+        uint8_t riff[12];
+        if (std::fread(riff, 1, sizeof(riff), file_) != sizeof(riff) || std::memcmp(riff, "RIFF", 4) != 0 ||
+            std::memcmp(riff + 8, "WAVE", 4) != 0)
+        {
+            // Not a WAV file, treat the whole file as raw 16-bit mono
+            std::fseek(file_, 0, SEEK_END);
+            dataStart_ = 0;
+            dataEnd_ = std::ftell(file_);
+            return true;
+        }
+
+        bool haveFormat = false;
+        uint8_t chunk[8];
+        while (std::fread(chunk, 1, sizeof(chunk), file_) == sizeof(chunk))
+        {
+            const uint32_t size = readLe(chunk + 4, 4);
+
+            if (std::memcmp(chunk, "fmt ", 4) == 0)
+            {
+                uint8_t format[16];
+                if (size < sizeof(format) || std::fread(format, 1, sizeof(format), file_) != sizeof(format))
+                    return false;
+
+                const uint16_t encoding = readLe(format, 2);
+                channels_ = readLe(format + 2, 2);
+                sampleRate_ = readLe(format + 4, 4);
+                bytesPerSample_ = readLe(format + 14, 2) / 8;
+                haveFormat = true;
+
+                // PCM or WAVE_FORMAT_EXTENSIBLE, integer samples only
+                if ((encoding != 1 && encoding != 0xFFFE) || channels_ == 0 || bytesPerSample_ < 2 ||
+                    bytesPerSample_ > 4)
+                    return false;
+
+                std::fseek(file_, static_cast<long>(size - sizeof(format) + (size & 1)), SEEK_CUR);
+            }
+            else if (std::memcmp(chunk, "data", 4) == 0)
+            {
+                dataStart_ = std::ftell(file_);
+                dataEnd_ = dataStart_ + static_cast<long>(size);
+                return haveFormat;
+            }
+            else
+            {
+                std::fseek(file_, static_cast<long>(size + (size & 1)), SEEK_CUR);
+            }
+        }
+
+        return false;
+    }
+
+  public:
+    PcmFileAudioSource(std::string path, const uint32_t rawSampleRate, const bool loop = true)
+        : path_(std::move(path))
+        , loop_(loop)
+        , sampleRate_(rawSampleRate)
+    {
+    }
+
+    ~PcmFileAudioSource() override
+    {
+        end();
+    }
+
+    bool begin() override
+    {
+        file_ = std::fopen(path_.c_str(), "rb");
+        if (!file_)
+            return false;
+
+        if (!parseWavHeader())
+        {
+            end();
+            return false;
+        }
+
+        std::fseek(file_, dataStart_, SEEK_SET);
+        return true;
+    }
+
+    void end() override
+    {
+        if (file_)
+        {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    size_t read(int32_t *samples, const size_t count, const uint32_t timeoutMs) override
+    {
+        if (!file_)
+            return 0;
+
+        const size_t frameBytes = channels_ * bytesPerSample_;
+        uint8_t chunk[256];
+        size_t produced = 0;
+
+        while (produced < count)
+        {
+            long remaining = dataEnd_ - std::ftell(file_);
+            if (remaining < static_cast<long>(frameBytes))
+            {
+                if (!loop_)
+                    break;
+
+                std::fseek(file_, dataStart_, SEEK_SET);
+                remaining = dataEnd_ - dataStart_;
+                if (remaining < static_cast<long>(frameBytes))
+                    break;
+            }
+
+            const size_t frames = std::min(
+                {count - produced, sizeof(chunk) / frameBytes, static_cast<size_t>(remaining) / frameBytes});
+            if (std::fread(chunk, frameBytes, frames, file_) != frames)
+                break;
+
+            for (size_t f = 0; f < frames; ++f)
+            {
+                // Left-justify the first channel into a 32-bit word
+                const uint32_t raw = readLe(chunk + f * frameBytes, bytesPerSample_);
+                samples[produced++] = static_cast<int32_t>(raw << (32 - 8 * bytesPerSample_));
+            }
+        }
+
+        pace(produced, sampleRate_);
+        return produced;
+    }
+
+    [[nodiscard]] uint32_t sampleRate() const override
+    {
+        return sampleRate_;
+    }
+};
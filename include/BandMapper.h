@@ -0,0 +1,213 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+enum class BandScale : uint8_t
+{
+    LINEAR,
+    LOG,
+    MEL,
+    BARK,
+};
+
+static constexpr size_t BAND_SCALE_COUNT = 4;
+
+inline const char *bandScaleName(const BandScale scale)
+{
+    switch (scale)
+    {
+        case BandScale::LINEAR: return "linear";
+        case BandScale::LOG: return "log";
+        case BandScale::MEL: return "mel";
+        case BandScale::BARK: return "bark";
+        default: return "unknown";
+    }
+}
+
+inline bool parseBandScale(const char *name, BandScale &scale)
+{
+    for (size_t i = 0; i < BAND_SCALE_COUNT; ++i)
+    {
+        if (std::strcmp(name, bandScaleName(static_cast<BandScale>(i))) == 0)
+        {
+            scale = static_cast<BandScale>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Maps an FFT spectrum of TBins bins onto TBands output bands through a sparse table of
+// triangular weights, spaced evenly on a linear, log, mel or Bark frequency axis.
+// Each band owns a contiguous run of bins and weights, so map() is one forward pass.
+// The spectrum may also be several FFTs of different resolution laid end to end, see Segment.
+template <size_t TBands, size_t TBins>
+class BandMapper final
+{
+    struct Band
+    {
+        uint16_t firstBin;
+        uint16_t binCount;
+        uint16_t weightOffset;
+    };
+
+    // Triangles overlap their neighbours, so a bin lands in at most two bands,
+    // and a band narrower than a bin falls back to two interpolation weights.
+    static constexpr size_t MAX_WEIGHTS = 2 * TBins + 2 * TBands;
+    static constexpr size_t MAX_SEGMENTS = 2;
+
+    std::array<Band, TBands> bands_{};
+    std::array<float, MAX_WEIGHTS> weights_{};
+    std::array<float, TBands> centerHz_{};
+    std::array<size_t, MAX_SEGMENTS> usedBins_{};
+
+    static float toScale(const BandScale scale, const float hz)
+    {
+        switch (scale)
+        {
+            case BandScale::LOG: return std::log(hz);
+            case BandScale::MEL: return 2595.0f * std::log10(1.0f + hz / 700.0f);
+            case BandScale::BARK: return 26.81f * hz / (1960.0f + hz) - 0.53f;
+            case BandScale::LINEAR:
+            default: return hz;
+        }
+    }
+
+    static float fromScale(const BandScale scale, const float value)
+    {
+        switch (scale)
+        {
+            case BandScale::LOG: return std::exp(value);
+            case BandScale::MEL: return 700.0f * (std::pow(10.0f, value / 2595.0f) - 1.0f);
+            case BandScale::BARK: return 1960.0f * (value + 0.53f) / (26.28f - value);
+            case BandScale::LINEAR:
+            default: return value;
+        }
+    }
+
+  public:
+    static constexpr size_t BANDS = TBands;
+    static constexpr size_t SPECTRUM_SIZE = TBins;
+
+    // One FFT within the concatenated spectrum. Bands centered below `untilHz` read from the first
+    // segment that covers them, so a fine low-rate FFT can serve the bass and a short one the rest.
+    struct Segment
+    {
+        float binHz;    // Spacing between its bins (sampleRate / fftSize)
+        size_t offset;  // Index of its first bin in the spectrum
+        size_t bins;    // Bins it contributes
+        float untilHz;  // Upper end of the band centers it serves
+    };
+
+    // Rebuilds the weight table; binHz is the spacing between FFT bins (sampleRate / fftSize)
+    void configure(const BandScale scale, const float binHz, const float minHz, const float maxHz)
+    {
+        const Segment segment{binHz, 0, TBins, maxHz};
+        configure(scale, &segment, 1, minHz, maxHz);
+    }
+
+    // Multi-resolution variant; segments are ordered by rising untilHz, and the last one serves
+    // everything above the others
+    void configure(
+        const BandScale scale, const Segment *segments, const size_t count, const float minHz, const float maxHz)
+    {
+        const Segment &top = segments[count - 1];
+        const float lowest = toScale(scale, std::max(minHz, segments[0].binHz * 0.5f));
+        const float highest = toScale(scale, std::min(maxHz, top.binHz * static_cast<float>(top.bins - 1)));
+        const float step = (highest - lowest) / static_cast<float>(TBands + 1);
+
+        size_t offset = 0;
+        usedBins_ = {};
+
+        for (size_t b = 0; b < TBands; ++b)
+        {
+            const float centerHz = fromScale(scale, lowest + step * static_cast<float>(b + 1));
+            size_t s = 0;
+            while (s + 1 < count && centerHz >= segments[s].untilHz)
+                s++;
+
+            const Segment &segment = segments[s];
+            const size_t bins = segment.bins;
+            const float lo = fromScale(scale, lowest + step * static_cast<float>(b)) / segment.binHz;
+            const float center = centerHz / segment.binHz;
+            const float hi = fromScale(scale, lowest + step * static_cast<float>(b + 2)) / segment.binHz;
+
+            Band &band = bands_[b];
+            band.weightOffset = static_cast<uint16_t>(offset);
+            centerHz_[b] = centerHz;
+
+            const size_t first = static_cast<size_t>(std::ceil(lo));
+            const size_t last = std::min(static_cast<size_t>(std::floor(hi)), bins - 1);
+
+            float total = 0.0f;
+            if (hi - lo >= 2.0f && first <= last)
+            {
+                band.firstBin = static_cast<uint16_t>(first);
+                band.binCount = static_cast<uint16_t>(last - first + 1);
+                for (size_t i = first; i <= last; ++i)
+                {
+                    const float bin = static_cast<float>(i);
+                    const float w = bin <= center ? (bin - lo) / (center - lo) : (hi - bin) / (hi - center);
+                    weights_[offset + i - first] = std::max(w, 0.0f);
+                    total += weights_[offset + i - first];
+                }
+            }
+
+            if (total <= 0.0f)
+            {
+                // Narrower than the bin spacing: interpolate between the two bins around the center
+                const size_t below = std::min(static_cast<size_t>(center), bins - 2);
+                const float frac = std::clamp(center - static_cast<float>(below), 0.0f, 1.0f);
+                band.firstBin = static_cast<uint16_t>(below);
+                band.binCount = 2;
+                weights_[offset] = 1.0f - frac;
+                weights_[offset + 1] = frac;
+                total = 1.0f;
+            }
+
+            // Normalize so a band reports the weighted mean of its bins
+            for (size_t i = 0; i < band.binCount; ++i)
+            {
+                weights_[offset + i] /= total;
+            }
+
+            offset += band.binCount;
+            usedBins_[s] = std::max<size_t>(usedBins_[s], band.firstBin + band.binCount);
+            band.firstBin += static_cast<uint16_t>(segment.offset);
+        }
+    }
+
+    // Number of leading bins of a segment the table reads; bins above it need not be computed
+    [[nodiscard]] size_t usedBins(const size_t segment = 0) const
+    {
+        return usedBins_[segment];
+    }
+
+    // First band centered at or above hz (TBands if none)
+    [[nodiscard]] size_t bandAt(const float hz) const
+    {
+        return std::lower_bound(centerHz_.begin(), centerHz_.end(), hz) - centerHz_.begin();
+    }
+
+    void map(const float *spectrum, float *bands) const
+    {
+        for (size_t b = 0; b < TBands; ++b)
+        {
+            const Band &band = bands_[b];
+            const float *bins = spectrum + band.firstBin;
+            const float *w = weights_.data() + band.weightOffset;
+
+            float sum = 0.0f;
+            for (size_t i = 0; i < band.binCount; ++i)
+            {
+                sum += bins[i] * w[i];
+            }
+            bands[b] = sum;
+        }
+    }
+};
@@ -1,24 +1,31 @@
 ﻿#pragma once
 
 #include <array>
-#include <esp_timer.h>
+#include <cstdint>
+
+#include "OnsetDetector.h"
+#include "StreamingStats.h"
 
 class BeatDetector
 {
+  public:
+    using Onsets = OnsetDetector<BINS>;
+
+  private:
     // Constants for beat detection
-    static constexpr size_t HISTORY_SIZE = 64;
-    static constexpr float SENSITIVITY = 1.2f;        // Lowered from 1.5 to be more sensitive
     static constexpr uint32_t MIN_INTERVAL_MS = 300;  // Increased minimum time between beats
     static constexpr uint32_t MAX_INTERVAL_MS = 2000; // Maximum time between beats (30 BPM)
+    static constexpr size_t FLUX_HISTORY_SIZE = 512;  // Analysis frames, ~3 s at the default hop
+    static constexpr float FLUX_GATE_SIGMA = 1.0f;    // Beats must also stand out from the long-term flux
 
-    // Energy and beat tracking
-    std::array<float, HISTORY_SIZE> energy_history_{};
-    size_t history_index_ = 0;
+    // Spectral-flux onsets drive the beats
+    Onsets onsets_;
+    WindowStats<float, FLUX_HISTORY_SIZE> flux_history_;
 
-    // Time tracking for beats
+    // Time tracking for beats, in sample-clock milliseconds
+    uint32_t current_time_ = 0;
     uint32_t last_beat_time_ = 0;
-    std::array<uint32_t, 12> beat_intervals_{}; // Store more intervals for better averaging
-    size_t beat_interval_index_ = 0;
+    WindowMedian<uint32_t, 12> beat_intervals_; // Store more intervals for better averaging
 
     // Current BPM value
     float current_bpm_ = 0.0f;
@@ -31,67 +38,30 @@ class BeatDetector
 
     // Debug counters
     uint32_t total_beats_ = 0;
-    uint32_t start_time_ = 0;
 
   public:
-    BeatDetector()
-    {
-        energy_history_.fill(0);
-        beat_intervals_.fill(0);
-        start_time_ = esp_timer_get_time() / 1000;
-    }
-
-    // Called regularly with new spectrum data
-    void update(const std::array<float, MATRIX_WIDTH> &spectrum)
+    // Called once per analysis frame with the instantaneous (unsmoothed) band levels and the
+    // audio time at the end of the frame, taken from the sample count so that beat intervals
+    // do not depend on when the frame happened to be processed
+    void update(const std::array<float, BINS> &spectrum, const uint32_t current_time)
     {
         // Reset beat detection flag at the start of each update
         beat_detected_ = false;
 
-        // For 64 bins and 22050Hz sample rate and selecting bins 10-50
-        // 10     - 50
-        // 3445Hz - 17226Hz
-        float current_energy = 0;
-
-        for (size_t i = 1; i < BINS - 1; i++)
-        {
-            current_energy += spectrum[i];
-        }
-
-        // Store energy in history
-        energy_history_[history_index_] = current_energy;
-
-        // Calculate local average and standard deviation
-        float avg_energy = 0;
-        for (const auto &e : energy_history_)
-        {
-            avg_energy += e;
-        }
-        avg_energy /= HISTORY_SIZE;
-
-        // Calculate standard deviation
-        float variance = 0;
-        for (const auto &e : energy_history_)
-        {
-            const float diff = e - avg_energy;
-            variance += diff * diff;
-        }
-        variance /= HISTORY_SIZE;
-        const float std_dev = std::sqrt(variance);
-
-        // Detect beat - energy spike relative to recent history
-        const uint32_t current_time = esp_timer_get_time() / 1000;
-
-        // Using standard deviation-based threshold for dynamic sensitivity
-        const float threshold = avg_energy + (std_dev * SENSITIVITY);
+        onsets_.update(spectrum.data());
+        current_time_ = current_time;
 
         // Store current beat energy for visualization
-        current_beat_energy_ = current_energy / (threshold + 0.001f); // Normalized energy level
+        current_beat_energy_ = onsets_.strength();
+
+        // A full-band onset counts as a beat when it is also loud against the last few seconds
+        // of flux and enough time has passed since the last one
+        const float flux = onsets_.flux();
+        const bool above_history = flux > flux_history_.mean() + FLUX_GATE_SIGMA * flux_history_.stddev();
+        flux_history_.push(flux);
 
-        // Check if current energy exceeds threshold and enough time has passed since last beat
-        if (current_energy > threshold && (current_time - last_beat_time_ > MIN_INTERVAL_MS) &&
-            current_energy > 0.1)
+        if (onsets_.isOnset() && above_history && current_time - last_beat_time_ > MIN_INTERVAL_MS)
         {
-            // Small minimum threshold to avoid noise
             beat_detected_ = true;
             total_beats_++;
 
@@ -102,8 +72,7 @@ class BeatDetector
                 if (const uint32_t interval = current_time - last_beat_time_; interval < MAX_INTERVAL_MS)
                 {
                     // Store interval
-                    beat_intervals_[beat_interval_index_] = interval;
-                    beat_interval_index_ = (beat_interval_index_ + 1) % beat_intervals_.size();
+                    beat_intervals_.push(interval);
 
                     // Calculate BPM using median filtering
                     calculateBPM();
@@ -112,9 +81,6 @@ class BeatDetector
 
             last_beat_time_ = current_time;
         }
-
-        // Update history index
-        history_index_ = (history_index_ + 1) % HISTORY_SIZE;
     }
 
     // Check if a beat was detected in the current update cycle
@@ -123,13 +89,24 @@ class BeatDetector
         return beat_detected_;
     }
 
-    // Get the normalized beat energy (useful for visualizations)
+    void setOnsetGroups(const Onsets::GroupEdges &edges)
+    {
+        onsets_.setGroupEdges(edges);
+    }
+
+    // Per-group onsets of the last update
+    [[nodiscard]] const Onsets &getOnsets() const
+    {
+        return onsets_;
+    }
+
+    // Get the onset strength relative to its threshold (useful for visualizations)
     [[nodiscard]] float getBeatEnergy() const
     {
         return current_beat_energy_;
     }
 
-    // Get the time since the last beat in milliseconds
+    // Get the audio time since the last beat in milliseconds
     [[nodiscard]] uint32_t getTimeSinceLastBeat() const
     {
         if (last_beat_time_ == 0)
@@ -137,7 +114,13 @@ class BeatDetector
             return 0;
         }
 
-        return (esp_timer_get_time() / 1000) - last_beat_time_;
+        return current_time_ - last_beat_time_;
+    }
+
+    // Sample-clock time of the last beat in milliseconds, 0 before the first
+    [[nodiscard]] uint32_t getLastBeatTime() const
+    {
+        return last_beat_time_;
     }
 
     // Get the current BPM estimate
@@ -150,58 +133,18 @@ class BeatDetector
     [[nodiscard]] float getConfidence() const
     {
         // Simple confidence measure based on number of intervals collected
-        float confidence = 0;
-        for (const auto &interval : beat_intervals_)
-        {
-            if (interval > 0)
-            {
-                confidence += 1.0f;
-            }
-        }
-
-        return (confidence / beat_intervals_.size()) * 100.0f;
+        return static_cast<float>(beat_intervals_.size()) / beat_intervals_.CAPACITY * 100.0f;
     }
 
   private:
     void calculateBPM()
     {
-        // Copy valid intervals to a temporary array
-        std::array<uint32_t, 12> valid_intervals{};
-        size_t valid_count = 0;
-
-        for (const auto &interval : beat_intervals_)
-        {
-            if (interval > 0 && interval < MAX_INTERVAL_MS)
-            {
-                valid_intervals[valid_count++] = interval;
-            }
-        }
-
-        if (valid_count < 3)
+        // Only reasonable intervals are stored, so the window holds valid intervals only
+        if (beat_intervals_.size() < 3)
             return; // Need at least 3 intervals for reliable BPM
 
-        // Sort intervals for median calculation
-        for (size_t i = 0; i < valid_count - 1; i++)
-        {
-            for (size_t j = 0; j < valid_count - i - 1; j++)
-            {
-                if (valid_intervals[j] > valid_intervals[j + 1])
-                {
-                    std::swap(valid_intervals[j], valid_intervals[j + 1]);
-                }
-            }
-        }
-
         // Use median interval for BPM calculation to reduce outlier impact
-        uint32_t median_interval;
-        if (valid_count % 2 == 0)
-        {
-            median_interval = (valid_intervals[valid_count / 2 - 1] + valid_intervals[valid_count / 2]) / 2;
-        }
-        else
-        {
-            median_interval = valid_intervals[valid_count / 2];
-        }
+        const uint32_t median_interval = beat_intervals_.median();
 
         // Convert to BPM
         const float new_bpm = 60000.0f / median_interval;
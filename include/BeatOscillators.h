@@ -0,0 +1,153 @@
+﻿#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <pixeltypes.h>
+
+#include "AudioContext.h"
+
+// Waveforms over a 32-bit phase, 2^32 per cycle
+struct BeatWaveform
+{
+    static constexpr uint32_t QUARTER_CYCLE = 1u << 30;
+
+    static uint16_t sine16(const uint32_t phase)
+    {
+        return static_cast<uint16_t>(sin16(static_cast<uint16_t>(phase >> 16)) + 32768);
+    }
+
+    static uint8_t sine8(const uint32_t phase)
+    {
+        return static_cast<uint8_t>(sine16(phase) >> 8);
+    }
+
+    static uint8_t saw8(const uint32_t phase)
+    {
+        return static_cast<uint8_t>(phase >> 24);
+    }
+
+    static uint8_t triangle8(const uint32_t phase)
+    {
+        return triwave8(saw8(phase));
+    }
+
+    static uint8_t square8(const uint32_t phase)
+    {
+        return phase < 0x80000000u ? 255 : 0;
+    }
+};
+
+// Beat-synchronous oscillators driven by a single phase accumulator. The position is 32.32 fixed
+// point in beats: the high word counts beats and the low word is the phase within the beat. update()
+// advances it once per frame at the current tempo and, while the tempo tracker is locked, pulls it
+// toward the tracker's beat clock. Waveforms are derived from the position on access, so unread
+// oscillators cost nothing and slow rates keep full precision instead of truncating bpm / 32.
+class BeatOscillators final
+{
+  public:
+    static constexpr uint8_t LOCK_SHIFT = 3; // Fraction 1 / 2^LOCK_SHIFT of the phase error removed per update
+
+  private:
+    uint64_t position_ = 0;
+    uint32_t lastUs_ = 0;
+    bool started_ = false;
+
+  public:
+    void update(const uint32_t nowUs, const AudioContext &audio)
+    {
+        const uint32_t elapsedUs = nowUs - lastUs_;
+        lastUs_ = nowUs;
+
+        // The first update only sets the reference time, so the phase does not jump by the uptime
+        if (!started_)
+        {
+            started_ = true;
+            return;
+        }
+
+        const bool locked = audio.tempoLocked() && audio.beatPeriodUs;
+        const uint32_t periodUs = locked ? audio.beatPeriodUs : audio.bpm ? 60000000u / audio.bpm : 0;
+        if (!periodUs)
+            return;
+
+        position_ += (static_cast<uint64_t>(elapsedUs) << 32) / periodUs;
+
+        if (locked)
+        {
+            const auto target = static_cast<uint32_t>(static_cast<uint64_t>(std::ldexp(audio.beatPhaseAt(nowUs), 32)));
+            const auto error = static_cast<int32_t>(target - static_cast<uint32_t>(position_));
+            position_ += static_cast<uint64_t>(static_cast<int64_t>(error >> LOCK_SHIFT));
+        }
+    }
+
+    // Whole beats since start
+    [[nodiscard]] uint32_t beats() const
+    {
+        return static_cast<uint32_t>(position_ >> 32);
+    }
+
+    // Phase of an oscillator running at `num` / `den` times the beat rate, 2^32 per cycle.
+    // `num` * `den` must stay below 2^32.
+    [[nodiscard]] uint32_t phase(const uint32_t num = 1, const uint32_t den = 1) const
+    {
+        const uint64_t wrapped = position_ % (static_cast<uint64_t>(den) << 32);
+        return static_cast<uint32_t>(wrapped * num / den);
+    }
+
+    [[nodiscard]] uint16_t sine16(const uint32_t num = 1, const uint32_t den = 1, const uint32_t offset = 0) const
+    {
+        return BeatWaveform::sine16(phase(num, den) + offset);
+    }
+
+    [[nodiscard]] uint8_t sine8(const uint32_t num = 1, const uint32_t den = 1, const uint32_t offset = 0) const
+    {
+        return BeatWaveform::sine8(phase(num, den) + offset);
+    }
+
+    [[nodiscard]] uint8_t saw8(const uint32_t num = 1, const uint32_t den = 1) const
+    {
+        return BeatWaveform::saw8(phase(num, den));
+    }
+
+    [[nodiscard]] uint8_t triangle8(const uint32_t num = 1, const uint32_t den = 1) const
+    {
+        return BeatWaveform::triangle8(phase(num, den));
+    }
+
+    [[nodiscard]] uint8_t square8(const uint32_t num = 1, const uint32_t den = 1) const
+    {
+        return BeatWaveform::square8(phase(num, den));
+    }
+
+    // Sine between `lowest` and `highest`, the accumulator counterpart of beatsin16
+    [[nodiscard]] uint16_t sineRange(const uint16_t lowest, const uint16_t highest, const uint32_t num = 1,
+                                     const uint32_t den = 1, const uint32_t offset = 0) const
+    {
+        return lowest + scale16(sine16(num, den, offset), highest - lowest);
+    }
+};
+
+// Read-only view of one waveform at the beat rate divided by 1, 2, 4 ... 32, indexed like the
+// per-frame oscillator arrays it replaces. Each read is computed from the accumulator.
+template <typename T>
+class BeatOscillatorView final
+{
+  public:
+    static constexpr size_t SIZE = 6;
+    using Waveform = T (*)(uint32_t phase);
+
+  private:
+    const BeatOscillators &bank_;
+    Waveform waveform_;
+
+  public:
+    BeatOscillatorView(const BeatOscillators &bank, const Waveform waveform) : bank_(bank), waveform_(waveform)
+    {
+    }
+
+    T operator[](const size_t divisorLog2) const
+    {
+        return waveform_(bank_.phase(1, 1u << divisorLog2));
+    }
+};
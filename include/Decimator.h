@@ -0,0 +1,81 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "FixedPoint.h"
+
+// Polyphase FIR decimator for raw 32-bit I2S words: low-pass at the output Nyquist, then keep every
+// TFactor-th sample. Only the kept outputs are filtered, so the cost is TTaps / TFactor multiplies
+// per input sample. The Blackman-windowed sinc passes the lower ~70% of the output band flat at
+// TTaps = 16 * TFactor; content near the output Nyquist partially aliases and should not be used.
+template <size_t TFactor, size_t TTaps>
+class Decimator final
+{
+    static_assert(TTaps % TFactor == 0, "Taps must split evenly into TFactor phases");
+
+    static constexpr std::array<q15_t, TTaps> genTaps()
+    {
+        std::array<double, TTaps> h{};
+        double sum = 0.0;
+        for (size_t i = 0; i < TTaps; ++i)
+        {
+            const double n = static_cast<double>(i) - static_cast<double>(TTaps - 1) / 2.0;
+            const double x = M_PI * n / static_cast<double>(TFactor);
+            const double sinc = n == 0.0 ? 1.0 : std::sin(x) / x;
+            const double w = 2.0 * M_PI * static_cast<double>(i) / static_cast<double>(TTaps - 1);
+            h[i] = sinc * (0.42 - 0.5 * std::cos(w) + 0.08 * std::cos(2.0 * w));
+            sum += h[i];
+        }
+
+        // Unity gain at DC
+        std::array<q15_t, TTaps> taps{};
+        for (size_t i = 0; i < TTaps; ++i)
+        {
+            taps[i] = static_cast<q15_t>(std::lround(h[i] / sum * 32768.0));
+        }
+        return taps;
+    }
+
+    static constexpr std::array<q15_t, TTaps> TAPS = genTaps();
+
+    // History written twice, so the newest TTaps samples are always contiguous
+    std::array<int16_t, 2 * TTaps> history_{};
+    size_t head_ = 0;
+    size_t phase_ = 0;
+
+  public:
+    static constexpr size_t FACTOR = TFactor;
+    static constexpr size_t TAP_COUNT = TTaps;
+
+    // Filters `count` input words into `out` and returns the number written, at most
+    // count / TFactor + 1. The decimation phase carries across calls, so any block size works.
+    size_t process(const int32_t *in, const size_t count, int32_t *out)
+    {
+        size_t written = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto sample = static_cast<int16_t>(in[i] >> 16);
+            history_[head_] = sample;
+            history_[head_ + TTaps] = sample;
+            head_ = (head_ + 1) % TTaps;
+
+            if (++phase_ < TFactor)
+                continue;
+            phase_ = 0;
+
+            // Q15 taps against 16-bit samples; the taps sum to ~1, so the total stays within int32
+            const int16_t *x = history_.data() + head_;
+            int32_t acc = 0;
+            for (size_t k = 0; k < TTaps; ++k)
+            {
+                acc += static_cast<int32_t>(TAPS[k]) * x[k];
+            }
+
+            out[written++] = std::clamp((acc + (1 << 14)) >> 15, -32768, 32767) * 65536;
+        }
+        return written;
+    }
+};
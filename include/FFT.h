@@ -0,0 +1,153 @@
+﻿#pragma once
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+
+// In-place iterative radix-2 FFT for a fixed power-of-two size.
+// Twiddle factors and the bit-reversal permutation are generated at compile time,
+// so a transform performs no trig calls and no allocations.
+template <size_t N>
+class FFT final
+{
+    static_assert(N >= 2 && std::has_single_bit(N), "FFT size must be a power of 2");
+
+    static constexpr std::array<std::complex<float>, N / 2> genTwiddles()
+    {
+        std::array<std::complex<float>, N / 2> table{};
+        for (size_t k = 0; k < N / 2; ++k)
+        {
+            const double angle = -2.0 * M_PI * static_cast<double>(k) / static_cast<double>(N);
+            table[k] = {static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle))};
+        }
+        return table;
+    }
+
+    static constexpr std::array<uint16_t, N> genBitReverse()
+    {
+        constexpr size_t bits = std::bit_width(N) - 1;
+        std::array<uint16_t, N> table{};
+        for (size_t i = 0; i < N; ++i)
+        {
+            size_t reversed = 0;
+            for (size_t b = 0; b < bits; ++b)
+            {
+                reversed |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            table[i] = static_cast<uint16_t>(reversed);
+        }
+        return table;
+    }
+
+  public:
+    static constexpr size_t SIZE = N;
+    static constexpr std::array<std::complex<float>, N / 2> TWIDDLES = genTwiddles();
+    static constexpr std::array<uint16_t, N> BIT_REVERSE = genBitReverse();
+
+    // Forward transform of N complex values, in place.
+    static void transform(std::complex<float> *x)
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (const size_t j = BIT_REVERSE[i]; i < j)
+            {
+                std::swap(x[i], x[j]);
+            }
+        }
+
+        // Complex multiplies are spelled out to avoid the NaN/Inf recovery path of std::complex operator*
+        for (size_t len = 2; len <= N; len <<= 1)
+        {
+            const size_t half = len / 2;
+            const size_t step = N / len;
+
+            for (size_t i = 0; i < N; i += len)
+            {
+                for (size_t k = 0; k < half; ++k)
+                {
+                    const std::complex<float> &w = TWIDDLES[k * step];
+                    std::complex<float> &a = x[i + k];
+                    std::complex<float> &b = x[i + k + half];
+
+                    const float tr = w.real() * b.real() - w.imag() * b.imag();
+                    const float ti = w.real() * b.imag() + w.imag() * b.real();
+
+                    b = {a.real() - tr, a.imag() - ti};
+                    a = {a.real() + tr, a.imag() + ti};
+                }
+            }
+        }
+    }
+};
+
+// Forward transform of N real samples through an N/2-point complex FFT plus a split pass.
+// The samples are packed pairwise into N/2 complex values (even index in the real part),
+// and the N/2 + 1 non-redundant bins (DC through Nyquist) are written back in place.
+template <size_t N>
+class RealFFT final
+{
+    static_assert(N >= 4 && std::has_single_bit(N), "Real FFT size must be a power of 2");
+
+    static constexpr size_t M = N / 2;
+
+    static constexpr std::array<std::complex<float>, M / 2 + 1> genSplitTwiddles()
+    {
+        std::array<std::complex<float>, M / 2 + 1> table{};
+        for (size_t k = 0; k <= M / 2; ++k)
+        {
+            const double angle = -2.0 * M_PI * static_cast<double>(k) / static_cast<double>(N);
+            table[k] = {static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle))};
+        }
+        return table;
+    }
+
+    static constexpr std::array<std::complex<float>, M / 2 + 1> SPLIT_TWIDDLES = genSplitTwiddles();
+
+    // X[k] = (Z[k] + conj(Z[M-k])) / 2 - i * W^k * (Z[k] - conj(Z[M-k])) / 2
+    static std::complex<float> split(
+        const std::complex<float> &zk,
+        const std::complex<float> &zmk,
+        const float wr,
+        const float wi)
+    {
+        const float evenR = 0.5f * (zk.real() + zmk.real());
+        const float evenI = 0.5f * (zk.imag() - zmk.imag());
+        const float oddR = 0.5f * (zk.imag() + zmk.imag());
+        const float oddI = -0.5f * (zk.real() - zmk.real());
+        return {evenR + wr * oddR - wi * oddI, evenI + wr * oddI + wi * oddR};
+    }
+
+  public:
+    static constexpr size_t SIZE = N;
+    static constexpr size_t BUFFER_SIZE = M + 1;
+    static constexpr size_t SPECTRUM_SIZE = M + 1;
+
+    // View of the packed buffer as N real samples for filling before transform()
+    static float *samples(std::complex<float> *data)
+    {
+        return reinterpret_cast<float *>(data);
+    }
+
+    // `data` must hold BUFFER_SIZE complex values; the first N/2 carry the packed real input.
+    static void transform(std::complex<float> *data)
+    {
+        FFT<M>::transform(data);
+
+        const std::complex<float> z0 = data[0];
+        data[0] = {z0.real() + z0.imag(), 0.0f};
+        data[M] = {z0.real() - z0.imag(), 0.0f};
+
+        for (size_t k = 1; k <= M / 2; ++k)
+        {
+            const std::complex<float> zk = data[k];
+            const std::complex<float> zmk = data[M - k];
+            const std::complex<float> &w = SPLIT_TWIDDLES[k];
+
+            // W^(M-k) = -conj(W^k)
+            data[k] = split(zk, zmk, w.real(), w.imag());
+            data[M - k] = split(zmk, zk, -w.real(), w.imag());
+        }
+    }
+};
@@ -0,0 +1,203 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+// Q15 / Q31 helpers for the fixed-point audio analysis path.
+// Q15 values are int16_t in [-1, 1), Q31 accumulators are int32_t.
+
+using q15_t = int16_t;
+using q31_t = int32_t;
+
+struct cq15_t
+{
+    q15_t re;
+    q15_t im;
+};
+
+FORCE_INLINE_ATTR q15_t sat15(const int32_t x)
+{
+    return static_cast<q15_t>(x > INT16_MAX ? INT16_MAX : (x < INT16_MIN ? INT16_MIN : x));
+}
+
+FORCE_INLINE_ATTR q15_t qadd15(const q15_t a, const q15_t b)
+{
+    return sat15(static_cast<int32_t>(a) + b);
+}
+
+FORCE_INLINE_ATTR q15_t qsub15(const q15_t a, const q15_t b)
+{
+    return sat15(static_cast<int32_t>(a) - b);
+}
+
+// Rounded Q15 x Q15 -> Q15 product
+FORCE_INLINE_ATTR q15_t qmul15(const q15_t a, const q15_t b)
+{
+    return sat15((static_cast<int32_t>(a) * b + (1 << 14)) >> 15);
+}
+
+// Integer square root, floor(sqrt(x))
+FORCE_INLINE_ATTR uint32_t isqrt32(uint32_t x)
+{
+    uint32_t result = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > x)
+        bit >>= 2;
+
+    while (bit != 0)
+    {
+        if (x >= result + bit)
+        {
+            x -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return result;
+}
+
+// log2(1 + i / 32) in Q16, with one guard entry for interpolation
+static constexpr std::array<uint32_t, 33> genLog2Table()
+{
+    std::array<uint32_t, 33> table{};
+    for (size_t i = 0; i <= 32; ++i)
+    {
+        table[i] = static_cast<uint32_t>(std::lround(std::log2(1.0 + static_cast<double>(i) / 32.0) * 65536.0));
+    }
+    return table;
+}
+
+static constexpr std::array<uint32_t, 33> LOG2_TABLE_Q16 = genLog2Table();
+
+// log2(x) in Q16.16 for x > 0, from the leading-one position and an interpolated mantissa table.
+// Absolute error stays below 1e-3.
+FORCE_INLINE_ATTR uint32_t log2Q16(const uint32_t x)
+{
+    if (x == 0)
+        return 0;
+
+    const uint32_t exponent = 31 - std::countl_zero(x);
+    const uint32_t mantissa = (x << (31 - exponent)) & 0x7FFFFFFF; // 31-bit fraction below the leading one
+    const uint32_t index = mantissa >> 26;                          // top 5 bits
+    const uint32_t frac = (mantissa >> 10) & 0xFFFF;                // next 16 bits
+    const uint32_t lo = LOG2_TABLE_Q16[index];
+    const uint32_t hi = LOG2_TABLE_Q16[index + 1];
+
+    return (exponent << 16) + lo + (((hi - lo) * frac) >> 16);
+}
+
+// In-place radix-2 Q15 FFT with block floating point scaling.
+// A stage is scaled down by one bit only when its input could overflow a butterfly, and the
+// number of shifts is returned so callers can recover the true magnitude as X * 2^shift.
+template <size_t N>
+class FFTQ15 final
+{
+    static_assert(N >= 2 && std::has_single_bit(N), "FFT size must be a power of 2");
+
+    // Largest component that survives a butterfly without overflow: 32767 / (1 + sqrt(2)), rounded down
+    static constexpr int32_t HEADROOM = 13572;
+
+    static constexpr std::array<cq15_t, N / 2> genTwiddles()
+    {
+        std::array<cq15_t, N / 2> table{};
+        for (size_t k = 0; k < N / 2; ++k)
+        {
+            const double angle = -2.0 * M_PI * static_cast<double>(k) / static_cast<double>(N);
+            table[k] = {
+                static_cast<q15_t>(std::lround(std::min(std::cos(angle) * 32768.0, 32767.0))),
+                static_cast<q15_t>(std::lround(std::min(std::sin(angle) * 32768.0, 32767.0))),
+            };
+        }
+        return table;
+    }
+
+    static constexpr std::array<uint16_t, N> genBitReverse()
+    {
+        constexpr size_t bits = std::bit_width(N) - 1;
+        std::array<uint16_t, N> table{};
+        for (size_t i = 0; i < N; ++i)
+        {
+            size_t reversed = 0;
+            for (size_t b = 0; b < bits; ++b)
+            {
+                reversed |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            table[i] = static_cast<uint16_t>(reversed);
+        }
+        return table;
+    }
+
+  public:
+    static constexpr size_t SIZE = N;
+    static constexpr int32_t MAX_SAFE = HEADROOM;
+    static constexpr std::array<cq15_t, N / 2> TWIDDLES = genTwiddles();
+    static constexpr std::array<uint16_t, N> BIT_REVERSE = genBitReverse();
+
+    static int32_t maxComponent(const cq15_t *x, const size_t count)
+    {
+        int32_t peak = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            peak = std::max(peak, std::max<int32_t>(std::abs(x[i].re), std::abs(x[i].im)));
+        }
+        return peak;
+    }
+
+    // Forward transform of N complex Q15 values in place, returns the applied right shift
+    static uint32_t transform(cq15_t *x)
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (const size_t j = BIT_REVERSE[i]; i < j)
+            {
+                std::swap(x[i], x[j]);
+            }
+        }
+
+        uint32_t shift = 0;
+        int32_t peak = maxComponent(x, N);
+
+        for (size_t len = 2; len <= N; len <<= 1)
+        {
+            const size_t half = len / 2;
+            const size_t step = N / len;
+            const int32_t scale = peak > HEADROOM ? 1 : 0;
+            shift += scale;
+            peak = 0;
+
+            for (size_t i = 0; i < N; i += len)
+            {
+                for (size_t k = 0; k < half; ++k)
+                {
+                    const cq15_t &w = TWIDDLES[k * step];
+                    cq15_t &a = x[i + k];
+                    cq15_t &b = x[i + k + half];
+
+                    const int32_t tr = (w.re * b.re - w.im * b.im + (1 << 14)) >> 15;
+                    const int32_t ti = (w.re * b.im + w.im * b.re + (1 << 14)) >> 15;
+
+                    const int32_t ar = (a.re + tr) >> scale;
+                    const int32_t ai = (a.im + ti) >> scale;
+                    const int32_t br = (a.re - tr) >> scale;
+                    const int32_t bi = (a.im - ti) >> scale;
+
+                    a = {sat15(ar), sat15(ai)};
+                    b = {sat15(br), sat15(bi)};
+
+                    peak = std::max({peak, std::abs(ar), std::abs(ai), std::abs(br), std::abs(bi)});
+                }
+            }
+        }
+
+        return shift;
+    }
+};
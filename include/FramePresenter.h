@@ -0,0 +1,283 @@
+﻿#pragma once
+
+#include <ESP32-HUB75-MatrixPanel-I2S-DMA.h>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <pixeltypes.h>
+
+#include "LatencyStats.h"
+#include "PanelLayout.h"
+#include "ThreadManager.h"
+#include "TripleBuffer.h"
+#include "Util.h"
+
+// Present stage of the render pipeline. The render loop composes each finished frame into back()
+// and publish()es it; a thread on the other core picks up the newest one and pushes it to the
+// panel while the next frame renders. Frames change hands through a triple buffer, so neither
+// side waits on the other: a slow present drops superseded frames instead of stalling the render,
+// and behind a slow render the panel keeps showing the last frame. Throughput is bounded by the
+// slower stage instead of the sum of both.
+//
+// Frames are kept in driver order. compose() builds one in a single linear sweep over the driver
+// pixels: gather both layers through the compile-time TLayout remap table, add them with saturation
+// and apply the output gamma, so presenting is a straight walk with no per-pixel coordinate math.
+// This moves the layout out of the present loop rather than making the frame cheaper: the driver
+// has no bulk write, so every pixel still goes through drawPixelRGB888, and the gather costs about
+// what the canvas-order compose and rotated present did (see test_compose_bench).
+// The present thread keeps a copy of what the panel shows and only forwards the spans of each row
+// that changed, found by comparing the packed rows a 32-bit word at a time.
+template <PanelLayout TLayout>
+class FramePresenter final
+{
+  public:
+    using Remap = PanelRemap<PANEL_WIDTH, PANEL_HEIGHT, PANELS_NUMBER, TLayout>;
+    static_assert(Remap::CANVAS_WIDTH == MATRIX_WIDTH && Remap::CANVAS_HEIGHT == MATRIX_HEIGHT,
+                  "Panel layout must cover the canvas exactly");
+
+    static constexpr size_t PIXELS = Remap::PIXELS;
+
+#ifdef NO_CIE1931
+    static constexpr float OUTPUT_GAMMA = 2.2f; // The driver's CIE1931 table is compiled out, so correct here
+#else
+    static constexpr float OUTPUT_GAMMA = 1.0f; // The driver corrects with its CIE1931 table
+#endif
+
+    static constexpr int PRESENT_THREAD_CORE = 0;
+    static constexpr size_t PRESENT_THREAD_STACK_SIZE = 4096;
+    static constexpr int PRESENT_THREAD_PRIORITY = 4; // Below MicFFT, so analysis is never held up by the panel
+
+    // Longest the present thread sleeps without a frame before re-checking that it should run
+    static constexpr uint32_t WAIT_TIMEOUT_MS = 100;
+
+    // Changed words this close together are pushed as one span, cheaper than restarting a span
+    static constexpr size_t SPAN_GAP_WORDS = 2;
+
+    static constexpr size_t ROW_BYTES = Remap::DRIVER_WIDTH * sizeof(CRGB);
+    static constexpr size_t ROW_WORDS = ROW_BYTES / sizeof(uint32_t);
+    static_assert(sizeof(CRGB) == 3 && ROW_BYTES % sizeof(uint32_t) == 0, "Rows must pack into whole words");
+
+    struct Frame
+    {
+        std::array<CRGB, PIXELS> pixels; // Driver order, row-major over the chained panels
+        uint8_t brightness;
+        bool freshAudio;            // Rendered with a new audio context, so timestamps are valid
+        AudioTimestamps timestamps; // Of the audio context the frame was rendered with
+        uint32_t renderedUs;
+    };
+
+    // Called on the present thread after each frame reached the panel
+    using PresentedFn = std::function<void(const Frame &frame, uint32_t presentedUs)>;
+
+  private:
+    static constexpr std::array<size_t, 256> GAMMA = GenGammaTable<OUTPUT_GAMMA, 256, 255>();
+
+    MatrixPanel_I2S_DMA *display_ = nullptr;
+    PresentedFn onPresented_;
+
+    TripleBuffer<Frame> frames_;
+    ThreadManager *presentThread_ = nullptr;
+    std::atomic<TaskHandle_t> presentTask_{nullptr};
+
+    // What the panel currently shows, present thread only
+    std::array<CRGB, PIXELS> shown_{};
+    int brightness_ = -1;
+    std::atomic<bool> fullRefresh_{true};
+
+    std::atomic<uint32_t> presentTimeUs_{0};
+    std::atomic<uint32_t> presentedFrames_{0};
+    std::atomic<uint32_t> pushedPixels_{0};
+    std::atomic<uint32_t> skippedPixels_{0};
+
+    static uint32_t word(const uint8_t *row, const size_t index)
+    {
+        uint32_t value;
+        std::memcpy(&value, row + index * sizeof(uint32_t), sizeof(value));
+        return value;
+    }
+
+    // Pushes pixels [first, last] of driver row `y` and records them as shown
+    void pushSpan(const Frame &frame, const size_t y, const size_t first, const size_t last)
+    {
+        const size_t offset = y * Remap::DRIVER_WIDTH;
+        const CRGB *led = frame.pixels.data() + offset + first;
+        for (size_t x = first; x <= last; ++x, ++led)
+        {
+            display_->drawPixelRGB888(static_cast<int16_t>(x), static_cast<int16_t>(y), led->r, led->g, led->b);
+        }
+        std::memcpy(shown_.data() + offset + first, frame.pixels.data() + offset + first,
+                    (last - first + 1) * sizeof(CRGB));
+    }
+
+    // Pushes the parts of `frame` that differ from shown_, returns the number of pixels pushed
+    size_t pushChanges(const Frame &frame)
+    {
+        size_t pushed = 0;
+        for (size_t y = 0; y < Remap::DRIVER_HEIGHT; ++y)
+        {
+            const auto *now = reinterpret_cast<const uint8_t *>(frame.pixels.data() + y * Remap::DRIVER_WIDTH);
+            const auto *was = reinterpret_cast<const uint8_t *>(shown_.data() + y * Remap::DRIVER_WIDTH);
+            if (std::memcmp(now, was, ROW_BYTES) == 0)
+            {
+                continue;
+            }
+
+            size_t w = 0;
+            while (w < ROW_WORDS)
+            {
+                if (word(now, w) == word(was, w))
+                {
+                    ++w;
+                    continue;
+                }
+
+                // Grow the span over changed words until a gap wider than SPAN_GAP_WORDS
+                size_t end = w;
+                for (size_t k = w + 1; k < ROW_WORDS && k <= end + SPAN_GAP_WORDS; ++k)
+                {
+                    if (word(now, k) != word(was, k))
+                    {
+                        end = k;
+                    }
+                }
+
+                // Pixels overlapping the changed bytes
+                const size_t first = w * sizeof(uint32_t) / sizeof(CRGB);
+                const size_t last = ((end + 1) * sizeof(uint32_t) - 1) / sizeof(CRGB);
+                pushSpan(frame, y, first, last);
+                pushed += last - first + 1;
+                w = end + 1;
+            }
+        }
+        return pushed;
+    }
+
+  public:
+    // Render side: frame to fill before the next publish()
+    Frame &back()
+    {
+        return frames_.back();
+    }
+
+    // Render side: fills `frame` from two row-major canvases of MATRIX_WIDTH * MATRIX_HEIGHT pixels
+    static void compose(const CRGB *layer, const CRGB *background, Frame &frame)
+    {
+        if constexpr (OUTPUT_GAMMA != 1.0f)
+        {
+            Remap::compose(layer, background, frame.pixels.data(), GAMMA);
+        }
+        else
+        {
+            Remap::compose(layer, background, frame.pixels.data());
+        }
+    }
+
+    // Render side: hands back() to the present thread and wakes it
+    void publish()
+    {
+        frames_.publish();
+        if (const TaskHandle_t task = presentTask_.load())
+        {
+            xTaskNotifyGive(task);
+        }
+    }
+
+    void start(MatrixPanel_I2S_DMA *display, PresentedFn onPresented = nullptr)
+    {
+        display_ = display;
+        onPresented_ = std::move(onPresented);
+
+        presentThread_ = new ThreadManager(
+            "Present", PRESENT_THREAD_CORE, PRESENT_THREAD_STACK_SIZE, PRESENT_THREAD_PRIORITY);
+        presentThread_->start([this](const std::atomic<bool> &running) { presentThreadFunc(running); });
+    }
+
+    void stop()
+    {
+        delete presentThread_;
+        presentThread_ = nullptr;
+        presentTask_.store(nullptr);
+    }
+
+    // Pushes every pixel of the next frame, for when the panel may no longer show the last one
+    void invalidate()
+    {
+        fullRefresh_.store(true);
+    }
+
+    // Duration of the last push to the panel
+    [[nodiscard]] uint32_t getPresentTimeUs() const
+    {
+        return presentTimeUs_.load();
+    }
+
+    // Frames that reached the panel so far
+    [[nodiscard]] uint32_t getPresentedFrames() const
+    {
+        return presentedFrames_.load();
+    }
+
+    // Pixels forwarded to the driver and pixels skipped as unchanged, over all presented frames
+    [[nodiscard]] uint32_t getPushedPixels() const
+    {
+        return pushedPixels_.load();
+    }
+
+    [[nodiscard]] uint32_t getSkippedPixels() const
+    {
+        return skippedPixels_.load();
+    }
+
+  private:
+    void presentThreadFunc(const std::atomic<bool> &running)
+    {
+        Serial.printf("Present thread started on core %d\n", xPortGetCoreID());
+        presentTask_.store(xTaskGetCurrentTaskHandle());
+
+        while (running)
+        {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WAIT_TIMEOUT_MS));
+            if (!frames_.acquire())
+            {
+                continue;
+            }
+
+            const Frame &frame = frames_.front();
+            const uint32_t startUs = esp_timer_get_time();
+
+            // Brightness rewrites the driver's output-enable timing, so only touch it on a change
+            if (frame.brightness != brightness_)
+            {
+                brightness_ = frame.brightness;
+                display_->setBrightness8(brightness_);
+            }
+
+            size_t pushed = PIXELS;
+            if (fullRefresh_.exchange(false))
+            {
+                for (size_t y = 0; y < Remap::DRIVER_HEIGHT; ++y)
+                {
+                    pushSpan(frame, y, 0, Remap::DRIVER_WIDTH - 1);
+                }
+            }
+            else
+            {
+                pushed = pushChanges(frame);
+            }
+            pushedPixels_.fetch_add(pushed);
+            skippedPixels_.fetch_add(PIXELS - pushed);
+
+            const uint32_t presentedUs = esp_timer_get_time();
+            presentTimeUs_.store(presentedUs - startUs);
+            presentedFrames_.fetch_add(1);
+
+            if (onPresented_)
+            {
+                onPresented_(frame, presentedUs);
+            }
+        }
+
+        Serial.println("Present thread ended");
+    }
+};
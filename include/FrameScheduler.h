@@ -0,0 +1,136 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+// Paces the render loop to a target frame rate against absolute deadlines on the esp_timer clock.
+// Each frame owns one period-long slot: beginFrame() opens it and reports the time since the last
+// frame, endFrame() measures the slack left in it, and idle() sleeps out the rest. Deadlines advance
+// by whole periods, so timing does not drift with render time. A frame that overruns its slot drops
+// the slots it missed instead of rushing the next frames to catch up.
+class FrameScheduler final
+{
+  public:
+    static constexpr uint32_t FPS_MIN = 10;
+    static constexpr uint32_t FPS_MAX = 240;
+    static constexpr uint32_t FPS_DEFAULT = 60;
+
+    // idle() sleeps in whole RTOS ticks, so it may wake up to one tick past the deadline; only the
+    // last SPIN_US before the deadline are spun out
+    static constexpr uint32_t TICK_US = portTICK_PERIOD_MS * 1000;
+    static constexpr uint32_t SPIN_US = 50;
+
+    struct Stats
+    {
+        uint32_t targetFps;
+        uint32_t frames;
+        uint32_t overruns;   // Frames that finished after their deadline
+        int32_t lastSlackUs; // Negative when the last frame overran
+        int32_t minSlackUs;  // Since the last resetStats()
+        uint32_t lastDeltaUs;
+    };
+
+  private:
+    std::atomic<uint32_t> targetFps_{FPS_DEFAULT};
+    uint32_t periodUs_ = 0;
+    int64_t deadlineUs_ = 0; // End of the current slot
+    int64_t frameStartUs_ = 0;
+
+    Stats stats_{};
+    std::atomic<bool> resetStats_{true};
+
+  public:
+    // Safe to call from any thread; takes effect on the next frame
+    bool setTargetFps(const uint32_t fps)
+    {
+        if (fps < FPS_MIN || fps > FPS_MAX)
+        {
+            return false;
+        }
+
+        targetFps_.store(fps);
+        return true;
+    }
+
+    [[nodiscard]] uint32_t getTargetFps() const
+    {
+        return targetFps_.load();
+    }
+
+    [[nodiscard]] uint32_t periodUs() const
+    {
+        return periodUs_;
+    }
+
+    // Opens the next slot and returns the time since the previous frame began
+    uint32_t beginFrame(const int64_t nowUs)
+    {
+        if (resetStats_.exchange(false))
+        {
+            stats_ = {};
+            stats_.minSlackUs = INT32_MAX;
+        }
+
+        const uint32_t periodUs = 1000000 / targetFps_.load();
+        if (periodUs != periodUs_ || frameStartUs_ == 0)
+        {
+            // First frame or new rate: restart the deadline grid here
+            periodUs_ = periodUs;
+            deadlineUs_ = nowUs;
+        }
+
+        const auto deltaUs = static_cast<uint32_t>(frameStartUs_ ? nowUs - frameStartUs_ : periodUs_);
+        frameStartUs_ = nowUs;
+        deadlineUs_ += periodUs_;
+
+        stats_.targetFps = targetFps_.load();
+        stats_.lastDeltaUs = deltaUs;
+        return deltaUs;
+    }
+
+    // Closes the slot and returns its slack, negative on overrun
+    int32_t endFrame(const int64_t nowUs)
+    {
+        const auto slackUs = static_cast<int32_t>(std::clamp<int64_t>(deadlineUs_ - nowUs, INT32_MIN, INT32_MAX));
+
+        stats_.frames++;
+        stats_.lastSlackUs = slackUs;
+        stats_.minSlackUs = std::min(stats_.minSlackUs, slackUs);
+
+        if (slackUs < 0)
+        {
+            // Skip the slots this frame ran into; the next one starts right away
+            stats_.overruns++;
+            deadlineUs_ += static_cast<int64_t>(-slackUs) / periodUs_ * periodUs_;
+        }
+        return slackUs;
+    }
+
+    // Waits for the deadline, overshooting it by less than one tick
+    void idle() const
+    {
+        // A delay of n ticks ends on the n-th tick interrupt, which can be up to a tick early, so
+        // sleep again while more than SPIN_US remain
+        for (int64_t remainingUs = deadlineUs_ - esp_timer_get_time(); remainingUs > SPIN_US;
+             remainingUs = deadlineUs_ - esp_timer_get_time())
+        {
+            vTaskDelay(static_cast<TickType_t>((remainingUs + TICK_US - 1) / TICK_US));
+        }
+        while (deadlineUs_ - esp_timer_get_time() > 0)
+        {
+        }
+    }
+
+    // Render thread only; see resetStats() for other threads
+    [[nodiscard]] const Stats &stats() const
+    {
+        return stats_;
+    }
+
+    // Safe to call from any thread; takes effect on the next frame
+    void resetStats()
+    {
+        resetStats_.store(true);
+    }
+};
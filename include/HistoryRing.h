@@ -0,0 +1,122 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+template <typename T, size_t TCapacity>
+class HistoryRing;
+
+// Read-only window into a HistoryRing as of one generation, small enough to copy along with a
+// context. Taking a view copies nothing; read() copies single items straight out of the ring's
+// storage. While the view is held the writer keeps appending and overwrites the oldest items, so
+// size() shrinks as it moves on, and an item can be overwritten while it is being copied. read()
+// re-checks the generation after the copy, seqlock style, and callers must drop the item when it
+// returns false.
+template <typename T, size_t TCapacity>
+class HistoryView final
+{
+    const HistoryRing<T, TCapacity> *ring_ = nullptr;
+    uint32_t generation_ = 0;
+
+  public:
+    HistoryView() = default;
+
+    HistoryView(const HistoryRing<T, TCapacity> *ring, const uint32_t generation)
+        : ring_(ring), generation_(generation)
+    {
+    }
+
+    // Items appended before this view was taken; the difference between two views is the
+    // number of items that arrived in between
+    [[nodiscard]] uint32_t generation() const
+    {
+        return generation_;
+    }
+
+    // Items that can still be read, newest first. The slot the writer fills next is never counted.
+    [[nodiscard]] size_t size() const
+    {
+        if (!ring_)
+            return 0;
+
+        const uint32_t behind = ring_->generation() - generation_;
+        if (behind >= TCapacity - 1)
+            return 0;
+
+        return std::min<size_t>(generation_, TCapacity - 1 - behind);
+    }
+
+    // Copies the item appended `age` items before the view was taken, 0 being the newest, into
+    // `out`. Returns false if the item is gone or the writer reached its slot during the copy, in
+    // which case `out` may be torn; older items are gone too by then.
+    bool read(const size_t age, T &out) const
+    {
+        if (age >= size())
+            return false;
+
+        out = ring_->at(generation_ - 1 - static_cast<uint32_t>(age));
+
+        // Keep the copy ahead of the re-check below
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint32_t behind = ring_->generation() - generation_;
+        return behind + age < TCapacity - 1;
+    }
+};
+
+// Single-writer history of the last TCapacity items, read through HistoryViews from other threads
+// without locks or snapshots. The writer fills next() and commit()s it; the generation counts the
+// commits and is what views are anchored to.
+template <typename T, size_t TCapacity>
+class HistoryRing final
+{
+    static_assert(TCapacity >= 2 && (TCapacity & (TCapacity - 1)) == 0, "Capacity must be a power of two");
+
+    static constexpr uint32_t MASK = TCapacity - 1;
+
+    std::array<T, TCapacity> items_{};
+    std::atomic<uint32_t> generation_{0};
+
+  public:
+    static constexpr size_t CAPACITY = TCapacity;
+    using View = HistoryView<T, TCapacity>;
+
+    // Writer: slot of the next item, readers see it after commit()
+    T &next()
+    {
+        return items_[generation_.load(std::memory_order_relaxed) & MASK];
+    }
+
+    void commit()
+    {
+        generation_.store(generation_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+        // Keep writes to the next slot from becoming visible before this generation, so a reader
+        // that copied any of them sees the slot as overwritten when it re-checks
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void push(const T &item)
+    {
+        next() = item;
+        commit();
+    }
+
+    [[nodiscard]] uint32_t generation() const
+    {
+        return generation_.load(std::memory_order_acquire);
+    }
+
+    // Item by generation index; it stays valid until the writer has gone TCapacity items further
+    [[nodiscard]] const T &at(const uint32_t index) const
+    {
+        return items_[index & MASK];
+    }
+
+    [[nodiscard]] View view() const
+    {
+        return View(this, generation());
+    }
+};
@@ -0,0 +1,123 @@
+﻿#pragma once
+
+#include <Arduino.h>
+#include <driver/i2s_std.h>
+#include <driver/i2s_types.h>
+#include <esp_err.h>
+
+#include "AudioSource.h"
+
+// The INMP441-style I2S microphone on the matrix board, read as 32-bit mono frames
+class I2sAudioSource final : public AudioSource
+{
+    static constexpr gpio_num_t MIC_WS = GPIO_NUM_15;
+    static constexpr gpio_num_t MIC_SCK = GPIO_NUM_14;
+    static constexpr gpio_num_t MIC_SD = GPIO_NUM_32;
+
+    // Small DMA frames let hop-sized reads return evenly spaced
+    static constexpr uint32_t DMA_FRAME_NUM = 64;
+
+    uint32_t sampleRate_;
+    i2s_chan_handle_t rxChan_{};
+
+  public:
+    explicit I2sAudioSource(const uint32_t sampleRate)
+        : sampleRate_(sampleRate)
+    {
+    }
+
+    ~I2sAudioSource() override
+    {
+        end();
+    }
+
+    bool begin() override
+    {
+        constexpr i2s_chan_config_t chan_cfg = {
+            .id = I2S_NUM_0,
+            .role = I2S_ROLE_MASTER,
+            .dma_desc_num = 8,
+            .dma_frame_num = DMA_FRAME_NUM,
+            .auto_clear = true,
+            .auto_clear_before_cb = true,
+            .allow_pd = false,
+            .intr_priority = 0,
+        };
+
+        esp_err_t err = i2s_new_channel(&chan_cfg, nullptr, &rxChan_);
+        if (err != ESP_OK)
+        {
+            Serial.printf("Failed to create I2S RX channel: %s\n", esp_err_to_name(err));
+            rxChan_ = nullptr;
+            return false;
+        }
+
+        const i2s_std_config_t std_cfg = {
+            .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(sampleRate_),
+            .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_32BIT, I2S_SLOT_MODE_MONO),
+            .gpio_cfg =
+                {
+                    .mclk = I2S_GPIO_UNUSED,
+                    .bclk = MIC_SCK,
+                    .ws = MIC_WS,
+                    .dout = I2S_GPIO_UNUSED,
+                    .din = MIC_SD,
+                    .invert_flags =
+                        {
+                            .mclk_inv = false,
+                            .bclk_inv = false,
+                            .ws_inv = false,
+                        },
+                },
+        };
+
+        err = i2s_channel_init_std_mode(rxChan_, &std_cfg);
+        if (err != ESP_OK)
+        {
+            Serial.printf("Failed to initialize I2S RX channel in STD mode: %s\n", esp_err_to_name(err));
+            i2s_del_channel(rxChan_);
+            rxChan_ = nullptr;
+            return false;
+        }
+
+        err = i2s_channel_enable(rxChan_);
+        if (err != ESP_OK)
+        {
+            Serial.printf("Failed to enable I2S RX channel: %s\n", esp_err_to_name(err));
+            i2s_del_channel(rxChan_);
+            rxChan_ = nullptr;
+            return false;
+        }
+
+        return true;
+    }
+
+    void end() override
+    {
+        if (rxChan_)
+        {
+            i2s_channel_disable(rxChan_);
+            i2s_del_channel(rxChan_);
+            rxChan_ = nullptr;
+        }
+    }
+
+    // The blocking DMA read paces the caller, no extra pacing is applied
+    size_t read(int32_t *samples, const size_t count, const uint32_t timeoutMs) override
+    {
+        size_t bytes_read = 0;
+        const esp_err_t err =
+            i2s_channel_read(rxChan_, samples, count * sizeof(int32_t), &bytes_read, pdMS_TO_TICKS(timeoutMs));
+        if (err != ESP_OK)
+        {
+            return 0;
+        }
+
+        return bytes_read / sizeof(int32_t);
+    }
+
+    [[nodiscard]] uint32_t sampleRate() const override
+    {
+        return sampleRate_;
+    }
+};
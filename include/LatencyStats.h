@@ -0,0 +1,126 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#include "RingBuffer.h"
+
+// Audio-to-photon pipeline stages, each measured from the end of the previous one
+enum class LatencyStage : uint8_t
+{
+    ANALYSIS, // I2S read returned -> FFT and band mapping done
+    PUBLISH,  // FFT done -> smoothed, beat-tracked context published to the render side
+    RENDER,   // Published -> pattern finished rendering with it
+    PRESENT,  // Rendered -> pushed to the panel driver
+    TOTAL,    // I2S read returned -> pushed to the panel driver
+};
+
+static constexpr size_t LATENCY_STAGE_COUNT = 5;
+
+inline const char *latencyStageName(const LatencyStage stage)
+{
+    switch (stage)
+    {
+        case LatencyStage::ANALYSIS: return "analysis";
+        case LatencyStage::PUBLISH: return "publish";
+        case LatencyStage::RENDER: return "render";
+        case LatencyStage::PRESENT: return "present";
+        case LatencyStage::TOTAL: return "total";
+        default: return "unknown";
+    }
+}
+
+// Timestamps (esp_timer microseconds, truncated to 32 bits) carried with one audio frame
+struct AudioTimestamps
+{
+    uint32_t captureUs;
+    uint32_t analyzedUs;
+    uint32_t publishedUs;
+};
+
+// Keeps the last TSamples per-stage latencies in fixed rings and summarizes them on request.
+// record() is a handful of stores per frame; summarize() sorts a copy and is meant for reports only.
+template <size_t TSamples>
+class LatencyStats
+{
+  public:
+    // Upper bucket edges in microseconds; the last bucket is open-ended
+    static constexpr std::array<uint32_t, 8> BUCKET_EDGES_US = {
+        1000,
+        2000,
+        5000,
+        10000,
+        20000,
+        50000,
+        100000,
+        UINT32_MAX,
+    };
+
+    struct Summary
+    {
+        size_t count;
+        uint32_t minUs;
+        uint32_t p50Us;
+        uint32_t p90Us;
+        uint32_t p99Us;
+        uint32_t maxUs;
+        std::array<uint32_t, BUCKET_EDGES_US.size()> histogram;
+    };
+
+  private:
+    std::array<RingBuffer<uint32_t, TSamples>, LATENCY_STAGE_COUNT> samples_{};
+    size_t count_ = 0;
+
+  public:
+    void record(const AudioTimestamps &audio, const uint32_t renderedUs, const uint32_t presentedUs)
+    {
+        samples_[static_cast<size_t>(LatencyStage::ANALYSIS)].push(audio.analyzedUs - audio.captureUs);
+        samples_[static_cast<size_t>(LatencyStage::PUBLISH)].push(audio.publishedUs - audio.analyzedUs);
+        samples_[static_cast<size_t>(LatencyStage::RENDER)].push(renderedUs - audio.publishedUs);
+        samples_[static_cast<size_t>(LatencyStage::PRESENT)].push(presentedUs - renderedUs);
+        samples_[static_cast<size_t>(LatencyStage::TOTAL)].push(presentedUs - audio.captureUs);
+        count_ = std::min(count_ + 1, TSamples);
+    }
+
+    [[nodiscard]] Summary summarize(const LatencyStage stage) const
+    {
+        Summary summary{};
+        summary.count = count_;
+        if (count_ == 0)
+        {
+            return summary;
+        }
+
+        // The ring is zero-filled until it wraps, so only the newest count_ entries are valid
+        std::array<uint32_t, TSamples> sorted{};
+        samples_[static_cast<size_t>(stage)].copyTo(sorted.data());
+        const auto begin = sorted.begin() + (TSamples - count_);
+        std::sort(begin, sorted.end());
+
+        summary.minUs = *begin;
+        summary.p50Us = begin[count_ * 50 / 100];
+        summary.p90Us = begin[count_ * 90 / 100];
+        summary.p99Us = begin[count_ * 99 / 100];
+        summary.maxUs = sorted.back();
+
+        size_t bucket = 0;
+        for (auto it = begin; it != sorted.end(); ++it)
+        {
+            while (*it > BUCKET_EDGES_US[bucket])
+                bucket++;
+            summary.histogram[bucket]++;
+        }
+
+        return summary;
+    }
+
+    void clear()
+    {
+        for (auto &ring : samples_)
+        {
+            ring.clear();
+        }
+        count_ = 0;
+    }
+};
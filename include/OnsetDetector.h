@@ -0,0 +1,153 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "StreamingStats.h"
+
+// Spectral-flux onset detection over TBands band levels. Each frame the half-wave rectified
+// rise of every band is summed into TGroups contiguous band groups (an even split unless set
+// with setGroupEdges) plus one full-band channel, and a channel reports an onset when its flux
+// crosses an adaptive threshold of THRESHOLD_DELTA + THRESHOLD_MEDIAN_WEIGHT * median(recent
+// flux). Steady tones and pads produce no flux, so only the attacks of new sounds pass. A
+// channel re-arms once its flux falls back below the threshold. Cost per frame is one pass
+// over the bands plus an incremental median.
+template <size_t TBands, size_t TGroups = 4>
+class OnsetDetector final
+{
+    static_assert(TGroups > 0 && TGroups <= TBands, "Every group needs at least one band");
+
+  public:
+    static constexpr size_t GROUPS = TGroups;
+    using GroupEdges = std::array<size_t, TGroups + 1>;
+
+    // Flux is the mean rise per band, in the units of the band levels
+    static constexpr size_t THRESHOLD_WINDOW = 32; // Analysis frames, ~190 ms at the default hop
+    static constexpr float THRESHOLD_MEDIAN_WEIGHT = 1.5f;
+    static constexpr float THRESHOLD_DELTA = 1.0f;
+
+    // Flux must also be an outlier against the channel's long-term level; keeps noise in
+    // narrow groups (a few bands, a few FFT bins) from firing
+    static constexpr float OUTLIER_SIGMA = 3.0f;
+    static constexpr float OUTLIER_RATE = 1.0f / 256.0f; // Per frame, ~1.5 s at the default hop
+
+  private:
+    struct Channel
+    {
+        WindowMedian<float, THRESHOLD_WINDOW> history;
+        bool armed = true;
+        bool onset = false;
+        float flux = 0.0f;
+        float threshold = THRESHOLD_DELTA;
+        float mean = 0.0f;
+        float variance = 0.0f;
+
+        void update(const float value)
+        {
+            const float median = history.median();
+            const float outlier = mean + OUTLIER_SIGMA * std::sqrt(variance);
+            flux = value;
+            threshold = std::max(THRESHOLD_DELTA + THRESHOLD_MEDIAN_WEIGHT * median, outlier);
+            onset = armed && flux > threshold;
+            armed = (armed && !onset) || flux <= median;
+
+            history.push(value);
+            const float deviation = value - mean;
+            mean += OUTLIER_RATE * deviation;
+            variance += OUTLIER_RATE * (deviation * deviation - variance);
+        }
+    };
+
+    static constexpr GroupEdges evenEdges()
+    {
+        GroupEdges edges{};
+        for (size_t g = 0; g <= TGroups; ++g)
+        {
+            edges[g] = g * TBands / TGroups;
+        }
+        return edges;
+    }
+
+    std::array<float, TBands> previous_{};
+    GroupEdges edges_ = evenEdges();
+    std::array<Channel, TGroups> groups_{};
+    std::array<size_t, TGroups> peakBands_{};
+    Channel full_;
+
+  public:
+    // Group g covers bands [edges[g], edges[g + 1]); edges must start at 0, end at TBands and
+    // increase strictly. Onset history is kept, so this is cheap to call on a band scale change.
+    void setGroupEdges(const GroupEdges &edges)
+    {
+        edges_ = edges;
+    }
+
+    void update(const float *bands)
+    {
+        float total = 0.0f;
+
+        for (size_t g = 0; g < TGroups; ++g)
+        {
+            float flux = 0.0f;
+            float peak = -1.0f;
+
+            for (size_t i = edges_[g]; i < edges_[g + 1]; ++i)
+            {
+                const float rise = std::max(0.0f, bands[i] - previous_[i]);
+                previous_[i] = bands[i];
+                flux += rise;
+
+                if (rise > peak)
+                {
+                    peak = rise;
+                    peakBands_[g] = i;
+                }
+            }
+
+            total += flux;
+            groups_[g].update(flux / (edges_[g + 1] - edges_[g]));
+        }
+
+        full_.update(total / TBands);
+    }
+
+    // Full-band onset in the last frame
+    [[nodiscard]] bool isOnset() const
+    {
+        return full_.onset;
+    }
+
+    // Full-band flux relative to its threshold; above 1 means an onset
+    [[nodiscard]] float strength() const
+    {
+        return full_.flux / full_.threshold;
+    }
+
+    [[nodiscard]] float flux() const
+    {
+        return full_.flux;
+    }
+
+    [[nodiscard]] bool isOnset(const size_t group) const
+    {
+        return groups_[group].onset;
+    }
+
+    [[nodiscard]] float strength(const size_t group) const
+    {
+        return groups_[group].flux / groups_[group].threshold;
+    }
+
+    [[nodiscard]] float flux(const size_t group) const
+    {
+        return groups_[group].flux;
+    }
+
+    // Band with the largest rise in the group during the last frame
+    [[nodiscard]] size_t peakBand(const size_t group) const
+    {
+        return peakBands_[group];
+    }
+};
@@ -0,0 +1,140 @@
+﻿#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Rotation of the canvas as seen on the assembled panels, clockwise
+enum class PanelRotation : uint8_t
+{
+    ROTATE_0,
+    ROTATE_90,
+    ROTATE_180,
+    ROTATE_270,
+};
+
+// How the canvas sits on the panels. The driver sees the chain as one strip of panels; the strip
+// is folded into rows of `tilesX` panels, top row first, each row chained left to right or, when
+// `serpentine`, every other row right to left with its panels mounted upside down. The assembled
+// picture is then mirrored and rotated onto the canvas.
+struct PanelLayout
+{
+    PanelRotation rotation = PanelRotation::ROTATE_0;
+    bool mirrorX = false;
+    bool mirrorY = false;
+    uint8_t tilesX = 1;
+    bool serpentine = false;
+};
+
+// Compile-time table from driver pixel order (row-major over the chained strip) to canvas index,
+// so a present pass walks the driver linearly and gathers from the canvas without per-pixel math
+template <size_t TPanelWidth, size_t TPanelHeight, size_t TPanels, PanelLayout TLayout>
+class PanelRemap final
+{
+    static_assert(TLayout.tilesX > 0 && TPanels % TLayout.tilesX == 0, "Panels must fill whole rows");
+
+    static constexpr size_t TILES_Y = TPanels / TLayout.tilesX;
+    static constexpr size_t ASSEMBLED_WIDTH = TPanelWidth * TLayout.tilesX;
+    static constexpr size_t ASSEMBLED_HEIGHT = TPanelHeight * TILES_Y;
+    static constexpr bool TRANSPOSED =
+        TLayout.rotation == PanelRotation::ROTATE_90 || TLayout.rotation == PanelRotation::ROTATE_270;
+
+  public:
+    static constexpr size_t DRIVER_WIDTH = TPanelWidth * TPanels;
+    static constexpr size_t DRIVER_HEIGHT = TPanelHeight;
+    static constexpr size_t CANVAS_WIDTH = TRANSPOSED ? ASSEMBLED_HEIGHT : ASSEMBLED_WIDTH;
+    static constexpr size_t CANVAS_HEIGHT = TRANSPOSED ? ASSEMBLED_WIDTH : ASSEMBLED_HEIGHT;
+    static constexpr size_t PIXELS = DRIVER_WIDTH * DRIVER_HEIGHT;
+
+    static_assert(PIXELS <= UINT16_MAX + 1, "Canvas indices must fit in 16 bits");
+
+    // Canvas index shown at driver pixel (x, y)
+    static constexpr size_t canvasIndex(const size_t x, const size_t y)
+    {
+        // Panel in the chain and the pixel within it
+        const size_t panel = x / TPanelWidth;
+        size_t localX = x % TPanelWidth;
+        size_t localY = y;
+
+        const size_t row = panel / TLayout.tilesX;
+        size_t column = panel % TLayout.tilesX;
+        if (TLayout.serpentine && row % 2 == 1)
+        {
+            column = TLayout.tilesX - 1 - column;
+            localX = TPanelWidth - 1 - localX;
+            localY = TPanelHeight - 1 - localY;
+        }
+
+        size_t ax = column * TPanelWidth + localX;
+        size_t ay = row * TPanelHeight + localY;
+        if (TLayout.mirrorX)
+            ax = ASSEMBLED_WIDTH - 1 - ax;
+        if (TLayout.mirrorY)
+            ay = ASSEMBLED_HEIGHT - 1 - ay;
+
+        size_t cx = ax;
+        size_t cy = ay;
+        switch (TLayout.rotation)
+        {
+            case PanelRotation::ROTATE_0: break;
+            case PanelRotation::ROTATE_90:
+                cx = ay;
+                cy = ASSEMBLED_WIDTH - 1 - ax;
+                break;
+            case PanelRotation::ROTATE_180:
+                cx = ASSEMBLED_WIDTH - 1 - ax;
+                cy = ASSEMBLED_HEIGHT - 1 - ay;
+                break;
+            case PanelRotation::ROTATE_270:
+                cx = ASSEMBLED_HEIGHT - 1 - ay;
+                cy = ax;
+                break;
+        }
+
+        return cy * CANVAS_WIDTH + cx;
+    }
+
+  private:
+    static constexpr std::array<uint16_t, PIXELS> genTable()
+    {
+        std::array<uint16_t, PIXELS> table{};
+        for (size_t y = 0; y < DRIVER_HEIGHT; ++y)
+        {
+            for (size_t x = 0; x < DRIVER_WIDTH; ++x)
+            {
+                table[y * DRIVER_WIDTH + x] = static_cast<uint16_t>(canvasIndex(x, y));
+            }
+        }
+        return table;
+    }
+
+  public:
+    static constexpr std::array<uint16_t, PIXELS> TABLE = genTable();
+
+    // Fills `out` in driver order from two row-major canvases, gathering both through TABLE and adding
+    // them with the pixel type's saturating operator+
+    template <typename TPixel>
+    static void compose(const TPixel *layer, const TPixel *background, TPixel *out)
+    {
+        for (size_t i = 0; i < PIXELS; ++i)
+        {
+            const uint16_t source = TABLE[i];
+            out[i] = layer[source] + background[source];
+        }
+    }
+
+    // As above, with every channel mapped through `gamma` in the same sweep
+    template <typename TPixel, typename TGamma>
+    static void compose(const TPixel *layer, const TPixel *background, TPixel *out, const TGamma &gamma)
+    {
+        for (size_t i = 0; i < PIXELS; ++i)
+        {
+            const uint16_t source = TABLE[i];
+            TPixel pixel = layer[source] + background[source];
+            pixel.r = gamma[pixel.r];
+            pixel.g = gamma[pixel.g];
+            pixel.b = gamma[pixel.b];
+            out[i] = pixel;
+        }
+    }
+};
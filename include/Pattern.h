@@ -1,8 +1,10 @@
 ﻿#pragma once
 
+#include "BeatOscillators.h"
 #include "MatrixGfx.h"
 #include "MatrixNoise.h"
 #include "Microphone.h"
+#include "RenderProfiler.h"
 
 class Pattern
 {
@@ -48,14 +50,66 @@ class Pattern
     // Musically inclined data
     static AudioContext Audio;
 
-    static uint16_t beatSineOsci[6];       // full 0-65535
-    static uint8_t beatSineOsci8[6];       // byte sized 0-255
-    static uint8_t beatSineOsciWidth[6];   // matrix width, 0-63 or whatever...
-    static uint8_t beatCosineOsciWidth[6]; // matrix width, 0-63 or whatever...
-    static uint8_t beatSawOsci8[6];
-    static uint8_t beatSawOsciWidth[6];
-    static uint8_t beatSquareOsci8[6];
-    static uint8_t beatSquareOsciWidth[6];
+    // Beat-locked oscillators, advanced once per frame
+    static BeatOscillators Beat;
+
+    // Time since the previous frame began and the frame scheduler's nominal period; per-frame steps
+    // scaled by frameScale() keep their speed when frames run late or the target rate changes
+    static uint32_t FrameDeltaUs;
+    static uint32_t FramePeriodUs;
+
+    static float frameScale()
+    {
+        return FramePeriodUs ? static_cast<float>(FrameDeltaUs) / FramePeriodUs : 1.0f;
+    }
+
+    // Phase, angle or hue offset stepped once per frame. Each step is scaled by the frame delta and the
+    // fraction carried to the next frame, so the counter keeps its rate per second at any frame rate
+    // and wraps like the T it stands in for.
+    template <typename T>
+    class FrameCounter final
+    {
+        static_assert(sizeof(T) <= 2, "The position keeps 16 fraction bits");
+
+        uint32_t position_; // 16.16 fixed point
+
+      public:
+        FrameCounter(const T value = 0)
+            : position_(static_cast<uint32_t>(value) << 16)
+        {
+        }
+
+        operator T() const
+        {
+            return static_cast<T>(position_ >> 16);
+        }
+
+        FrameCounter &operator+=(const int32_t step)
+        {
+            const int64_t scaled = FramePeriodUs ? (static_cast<int64_t>(step) << 16) * FrameDeltaUs / FramePeriodUs
+                                                 : static_cast<int64_t>(step) << 16;
+            position_ += static_cast<uint32_t>(scaled);
+            return *this;
+        }
+
+        FrameCounter &operator-=(const int32_t step)
+        {
+            return *this += -step;
+        }
+    };
+
+    // Render times of every pattern, by ID
+    static RenderProfiler Profiler;
+
+    // Compatibility views over Beat, index i running at bpm / 2^i
+    static BeatOscillatorView<uint16_t> beatSineOsci;       // full 0-65535
+    static BeatOscillatorView<uint8_t> beatSineOsci8;       // byte sized 0-255
+    static BeatOscillatorView<uint8_t> beatSineOsciWidth;   // matrix width, 0-63 or whatever...
+    static BeatOscillatorView<uint8_t> beatCosineOsciWidth; // matrix width, 0-63 or whatever...
+    static BeatOscillatorView<uint8_t> beatSawOsci8;
+    static BeatOscillatorView<uint8_t> beatSawOsciWidth;
+    static BeatOscillatorView<uint8_t> beatSquareOsci8;
+    static BeatOscillatorView<uint8_t> beatSquareOsciWidth;
 
     virtual void start() = 0;
     virtual void render() = 0;
@@ -69,6 +123,21 @@ class Pattern
         return id_;
     }
 
+    // render() and backgroundPostProcess() timed into Profiler
+    void profiledRender()
+    {
+        const int64_t startUs = esp_timer_get_time();
+        render();
+        Profiler.record(id_, RenderPhase::RENDER, static_cast<uint32_t>(esp_timer_get_time() - startUs));
+    }
+
+    void profiledBackgroundPostProcess()
+    {
+        const int64_t startUs = esp_timer_get_time();
+        backgroundPostProcess();
+        Profiler.record(id_, RenderPhase::POST_PROCESS, static_cast<uint32_t>(esp_timer_get_time() - startUs));
+    }
+
     FORCE_INLINE_ATTR uint8_t beatcos8(
         const accum88 beats_per_minute,
         const uint8_t lowest = 0,
@@ -132,72 +201,6 @@ class Pattern
             default: return RainbowColors_p;
         }
     }
-
-    static void updateBpmOscillators(const uint16_t bpm)
-    {
-
-        // oscillators for sine wave forms at variuos rates proportional to the tempo
-        // do we need all these? used anywhere?
-        // scaled 0-65535
-        //
-        beatSineOsci[0] = beatsin16(bpm, 0, 65535);
-        beatSineOsci[1] = beatsin16(bpm / 2, 0, 65535);
-        beatSineOsci[2] = beatsin16(bpm / 4, 0, 65535);
-        beatSineOsci[3] = beatsin16(bpm / 8, 0, 65535);
-        beatSineOsci[4] = beatsin16(bpm / 16, 0, 65535);
-        beatSineOsci[5] = beatsin16(bpm / 32, 0, 65535);
-
-        // scaled 0-255
-        //
-        beatSineOsci8[0] = beatsin16(bpm, 0, 255);
-        beatSineOsci8[1] = beatsin16(bpm / 2, 0, 255);
-        beatSineOsci8[2] = beatsin16(bpm / 4, 0, 255);
-        beatSineOsci8[3] = beatsin16(bpm / 8, 0, 255);
-        beatSineOsci8[4] = beatsin16(bpm / 16, 0, 255);
-        beatSineOsci8[5] = beatsin16(bpm / 32, 0, 255);
-
-        // scaled for matrix width (e.g. 0-63)
-        //
-        beatSineOsciWidth[0] = beatsin16(bpm, 0, MATRIX_HEIGHT - 1);
-        beatSineOsciWidth[1] = beatsin16(bpm / 2, 0, MATRIX_HEIGHT - 1);
-        beatSineOsciWidth[2] = beatsin16(bpm / 4, 0, MATRIX_HEIGHT - 1);
-        beatSineOsciWidth[3] = beatsin16(bpm / 8, 0, MATRIX_HEIGHT - 1);
-        beatSineOsciWidth[4] = beatsin16(bpm / 16, 0, MATRIX_HEIGHT - 1);
-        beatSineOsciWidth[5] = beatsin16(bpm / 32, 0, MATRIX_HEIGHT - 1);
-        beatCosineOsciWidth[0] = beatsin16(bpm, 0, MATRIX_HEIGHT - 1, 0, 16384);
-        beatCosineOsciWidth[1] = beatsin16(bpm / 2, 0, MATRIX_HEIGHT - 1, 0, 16384);
-        beatCosineOsciWidth[2] = beatsin16(bpm / 4, 0, MATRIX_HEIGHT - 1, 0, 16384);
-        beatCosineOsciWidth[3] = beatsin16(bpm / 8, 0, MATRIX_HEIGHT - 1, 0, 16384);
-        beatCosineOsciWidth[4] = beatsin16(bpm / 16, 0, MATRIX_HEIGHT - 1, 0, 16384);
-        beatCosineOsciWidth[5] = beatsin16(bpm / 32, 0, MATRIX_HEIGHT - 1, 0, 16384);
-
-        // oscillators for saw tooth wave forms, scaled 0-255
-        //
-        beatSawOsci8[0] = beat8(bpm);
-        beatSawOsci8[1] = beat8(bpm / 2);
-        beatSawOsci8[2] = beat8(bpm / 4);
-        beatSawOsci8[3] = beat8(bpm / 8);
-        beatSawOsci8[4] = beat8(bpm / 16);
-        beatSawOsci8[5] = beat8(bpm / 32);
-
-        // scaled for matrix width
-        //
-        beatSawOsciWidth[0] = map8(beatSawOsci8[0], 0, MATRIX_HEIGHT - 1);
-        beatSawOsciWidth[1] = map8(beatSawOsci8[1], 0, MATRIX_HEIGHT - 1);
-        beatSawOsciWidth[2] = map8(beatSawOsci8[2], 0, MATRIX_HEIGHT - 1);
-        beatSawOsciWidth[3] = map8(beatSawOsci8[3], 0, MATRIX_HEIGHT - 1);
-        beatSawOsciWidth[4] = map8(beatSawOsci8[4], 0, MATRIX_HEIGHT - 1);
-        beatSawOsciWidth[5] = map8(beatSawOsci8[5], 0, MATRIX_HEIGHT - 1);
-
-        // oscillators for square wave forms, scaled 0-255
-        //
-        beatSquareOsci8[0] = squarewave8(beat8(bpm), 128);
-        beatSquareOsci8[1] = squarewave8(beat8(bpm / 2), 128);
-        beatSquareOsci8[2] = squarewave8(beat8(bpm / 4), 128);
-        beatSquareOsci8[3] = squarewave8(beat8(bpm / 8), 128);
-        beatSquareOsci8[4] = squarewave8(beat8(bpm / 16), 128);
-        beatSquareOsci8[5] = squarewave8(beat8(bpm / 32), 128);
-    }
 };
 
 MatrixGfx<MATRIX_WIDTH, MATRIX_HEIGHT> Pattern::Gfx{};
@@ -206,14 +209,23 @@ MatrixNoise<MATRIX_WIDTH, MATRIX_HEIGHT> Pattern::Noise{};
 MatrixGfx<MATRIX_WIDTH / 2, MATRIX_HEIGHT / 2> Pattern::GfxCanvasH;
 MatrixGfx<MATRIX_WIDTH / 4, MATRIX_HEIGHT / 4> Pattern::GfxCanvasQ;
 AudioContext Pattern::Audio{};
-uint16_t Pattern::beatSineOsci[6]{};
-uint8_t Pattern::beatSineOsci8[6]{};
-uint8_t Pattern::beatSineOsciWidth[6]{};
-uint8_t Pattern::beatCosineOsciWidth[6]{};
-uint8_t Pattern::beatSawOsci8[6]{};
-uint8_t Pattern::beatSawOsciWidth[6]{};
-uint8_t Pattern::beatSquareOsci8[6]{};
-uint8_t Pattern::beatSquareOsciWidth[6]{};
+BeatOscillators Pattern::Beat{};
+uint32_t Pattern::FrameDeltaUs = 0;
+uint32_t Pattern::FramePeriodUs = 0;
+RenderProfiler Pattern::Profiler{};
+BeatOscillatorView<uint16_t> Pattern::beatSineOsci{Beat, BeatWaveform::sine16};
+BeatOscillatorView<uint8_t> Pattern::beatSineOsci8{Beat, BeatWaveform::sine8};
+BeatOscillatorView<uint8_t> Pattern::beatSineOsciWidth{
+    Beat, [](const uint32_t phase) -> uint8_t { return scale16(BeatWaveform::sine16(phase), MATRIX_HEIGHT - 1); }};
+BeatOscillatorView<uint8_t> Pattern::beatCosineOsciWidth{Beat, [](const uint32_t phase) -> uint8_t {
+    return scale16(BeatWaveform::sine16(phase + BeatWaveform::QUARTER_CYCLE), MATRIX_HEIGHT - 1);
+}};
+BeatOscillatorView<uint8_t> Pattern::beatSawOsci8{Beat, BeatWaveform::saw8};
+BeatOscillatorView<uint8_t> Pattern::beatSawOsciWidth{
+    Beat, [](const uint32_t phase) -> uint8_t { return map8(BeatWaveform::saw8(phase), 0, MATRIX_HEIGHT - 1); }};
+BeatOscillatorView<uint8_t> Pattern::beatSquareOsci8{Beat, BeatWaveform::square8};
+BeatOscillatorView<uint8_t> Pattern::beatSquareOsciWidth{
+    Beat, [](const uint32_t phase) -> uint8_t { return map8(BeatWaveform::square8(phase), 0, MATRIX_HEIGHT - 1); }};
 
 template <class T>
 concept IPattern = std::is_base_of_v<Pattern, T>;
@@ -0,0 +1,79 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+enum class Percussion : uint8_t
+{
+    KICK,
+    SNARE,
+    HAT,
+};
+
+static constexpr size_t PERCUSSION_COUNT = 3;
+
+inline const char *percussionName(const Percussion percussion)
+{
+    switch (percussion)
+    {
+        case Percussion::KICK: return "kick";
+        case Percussion::SNARE: return "snare";
+        case Percussion::HAT: return "hat";
+        default: return "unknown";
+    }
+}
+
+struct PercussiveEvent
+{
+    bool hit;         // An event of this kind started since the previous context
+    uint8_t strength; // Onset flux against its threshold, 64 at the threshold, every frame
+    uint8_t band;     // Band that rose most in the event's range
+    uint32_t count;   // Events so far
+};
+
+// Onset group boundaries the classifier expects: kick/sub, snare body, snare crack, air
+static constexpr std::array<float, 3> PERCUSSION_SPLIT_HZ = {200.0f, 2000.0f, 6000.0f};
+
+// Sorts onsets of a four-group OnsetDetector laid out on PERCUSSION_SPLIT_HZ into kick, snare
+// and hi-hat events. Kicks are low-group onsets; snares are crack onsets with the body rising
+// too; hats are air onsets without a body.
+class PercussionClassifier final
+{
+  public:
+    // Body-group onset strength (flux over threshold) that marks a crack as a snare rather than a hat
+    static constexpr float SNARE_BODY_STRENGTH = 1.5f;
+
+  private:
+    std::array<PercussiveEvent, PERCUSSION_COUNT> events_{};
+
+    void set(const Percussion percussion, const bool hit, const float strength, const size_t band)
+    {
+        PercussiveEvent &event = events_[static_cast<size_t>(percussion)];
+        event.hit = hit;
+        event.strength = static_cast<uint8_t>(std::min(255.0f, 64.0f * strength));
+        event.band = static_cast<uint8_t>(band);
+        event.count += hit;
+    }
+
+  public:
+    template <typename TOnsets>
+    void update(const TOnsets &onsets)
+    {
+        static_assert(TOnsets::GROUPS == PERCUSSION_SPLIT_HZ.size() + 1, "Expects one onset group per range");
+
+        const bool body = onsets.strength(1) >= SNARE_BODY_STRENGTH;
+
+        set(Percussion::KICK, onsets.isOnset(0), onsets.strength(0), onsets.peakBand(0));
+        set(Percussion::SNARE,
+            onsets.isOnset(2) && body,
+            std::max(onsets.strength(1), onsets.strength(2)),
+            onsets.peakBand(2));
+        set(Percussion::HAT, onsets.isOnset(3) && !body, onsets.strength(3), onsets.peakBand(3));
+    }
+
+    [[nodiscard]] const PercussiveEvent &event(const Percussion percussion) const
+    {
+        return events_[static_cast<size_t>(percussion)];
+    }
+};
@@ -0,0 +1,151 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Timed calls into a pattern
+enum class RenderPhase : uint8_t
+{
+    RENDER,       // render()
+    POST_PROCESS, // backgroundPostProcess()
+};
+
+static constexpr size_t RENDER_PHASE_COUNT = 2;
+
+inline const char *renderPhaseName(const RenderPhase phase)
+{
+    switch (phase)
+    {
+        case RenderPhase::RENDER: return "render";
+        case RenderPhase::POST_PROCESS: return "postProcess";
+        default: return "unknown";
+    }
+}
+
+// Per-pattern render times, keyed by pattern ID. Each ID and phase keeps a fixed-bucket histogram, a
+// count, a total and the worst case, so memory stays flat however long a pattern runs and record() is
+// a map lookup plus a few adds. Percentiles are read off the histogram as the upper edge of the
+// bucket holding them, capped at the worst case. Recording and reporting may run on different threads.
+class RenderProfiler final
+{
+  public:
+    // Upper bucket edges in microseconds, dense around the 60 and 30 fps frame budgets; the last bucket
+    // is open-ended
+    static constexpr std::array<uint32_t, 14> BUCKET_EDGES_US = {
+        250,
+        500,
+        1000,
+        2000,
+        3000,
+        4000,
+        6000,
+        8000,
+        10000,
+        12500,
+        16667,
+        25000,
+        33333,
+        UINT32_MAX,
+    };
+
+    struct Summary
+    {
+        uint32_t count;
+        uint32_t meanUs;
+        uint32_t p50Us;
+        uint32_t p99Us;
+        uint32_t maxUs;
+        std::array<uint32_t, BUCKET_EDGES_US.size()> histogram;
+    };
+
+    using PatternSummary = std::array<Summary, RENDER_PHASE_COUNT>;
+
+  private:
+    struct Timings
+    {
+        uint32_t count;
+        uint64_t totalUs;
+        uint32_t maxUs;
+        std::array<uint32_t, BUCKET_EDGES_US.size()> histogram;
+    };
+
+    std::map<std::string, std::array<Timings, RENDER_PHASE_COUNT>, std::less<>> patterns_;
+    mutable std::mutex mutex_;
+
+    static uint32_t percentile(const Timings &timings, const uint32_t percent)
+    {
+        const uint32_t rank = timings.count * percent / 100;
+        uint32_t seen = 0;
+        for (size_t bucket = 0; bucket < BUCKET_EDGES_US.size(); ++bucket)
+        {
+            seen += timings.histogram[bucket];
+            if (seen > rank)
+            {
+                return std::min(BUCKET_EDGES_US[bucket], timings.maxUs);
+            }
+        }
+        return timings.maxUs;
+    }
+
+    static Summary summarize(const Timings &timings)
+    {
+        Summary summary{};
+        summary.count = timings.count;
+        if (timings.count == 0)
+        {
+            return summary;
+        }
+
+        summary.meanUs = static_cast<uint32_t>(timings.totalUs / timings.count);
+        summary.p50Us = percentile(timings, 50);
+        summary.p99Us = percentile(timings, 99);
+        summary.maxUs = timings.maxUs;
+        summary.histogram = timings.histogram;
+        return summary;
+    }
+
+  public:
+    void record(const std::string &id, const RenderPhase phase, const uint32_t us)
+    {
+        const auto bucket = static_cast<size_t>(
+            std::lower_bound(BUCKET_EDGES_US.begin(), BUCKET_EDGES_US.end(), us) - BUCKET_EDGES_US.begin());
+
+        std::lock_guard lock(mutex_);
+        Timings &timings = patterns_.try_emplace(id).first->second[static_cast<size_t>(phase)];
+        timings.count++;
+        timings.totalUs += us;
+        timings.maxUs = std::max(timings.maxUs, us);
+        timings.histogram[bucket]++;
+    }
+
+    // Copies every pattern's summaries out, so reports can be printed or serialized without holding up
+    // the render loop
+    [[nodiscard]] std::vector<std::pair<std::string, PatternSummary>> snapshot() const
+    {
+        std::vector<std::pair<std::string, PatternSummary>> result;
+
+        std::lock_guard lock(mutex_);
+        result.reserve(patterns_.size());
+        for (const auto &[id, phases] : patterns_)
+        {
+            PatternSummary &summaries = result.emplace_back(id, PatternSummary{}).second;
+            for (size_t i = 0; i < RENDER_PHASE_COUNT; ++i)
+            {
+                summaries[i] = summarize(phases[i]);
+            }
+        }
+        return result;
+    }
+
+    void clear()
+    {
+        std::lock_guard lock(mutex_);
+        patterns_.clear();
+    }
+};
@@ -0,0 +1,58 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <type_traits>
+
+// Fixed-capacity ring that always holds the last N pushed values (zero-filled until then).
+template <typename T, size_t N>
+class RingBuffer
+{
+    static_assert(std::is_trivially_copyable_v<T>, "RingBuffer copies elements with memcpy");
+
+    std::array<T, N> data_{};
+    size_t head_ = 0; // Next write position, which is also the oldest element
+
+  public:
+    static constexpr size_t CAPACITY = N;
+
+    void push(const T &value)
+    {
+        data_[head_] = value;
+        head_ = (head_ + 1) % N;
+    }
+
+    void push(const T *values, size_t count)
+    {
+        if (count >= N)
+        {
+            values += count - N;
+            count = N;
+        }
+
+        const size_t first = std::min(count, N - head_);
+        std::memcpy(data_.data() + head_, values, first * sizeof(T));
+        std::memcpy(data_.data(), values + first, (count - first) * sizeof(T));
+        head_ = (head_ + count) % N;
+    }
+
+    // Copies all N elements into out, oldest first
+    void copyTo(T *out) const
+    {
+        std::memcpy(out, data_.data() + head_, (N - head_) * sizeof(T));
+        std::memcpy(out + N - head_, data_.data(), head_ * sizeof(T));
+    }
+
+    // Element pushed `age` pushes ago, 0 being the newest
+    [[nodiscard]] const T &newest(const size_t age = 0) const
+    {
+        return data_[(head_ + N - 1 - age % N) % N];
+    }
+
+    void clear()
+    {
+        data_ = {};
+        head_ = 0;
+    }
+};
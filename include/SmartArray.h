@@ -77,4 +77,10 @@ class SmartArray
     {
         return data_.data();
     }
+
+    // The W * H elements row-major, past the out-of-bounds slot that data() starts with
+    [[nodiscard]] const T *elements() const
+    {
+        return data_.data() + 1;
+    }
 };
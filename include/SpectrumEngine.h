@@ -0,0 +1,140 @@
+﻿#pragma once
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+
+#include "FFT.h"
+#include "FixedPoint.h"
+#include "Window.h"
+
+// Window -> real FFT -> magnitude -> log scaling for one N-sample analysis frame.
+// Both engines write log(1 + LOG_SCALE_BASE * |X|) / log(1 + LOG_SCALE_BASE) per bin, so
+// everything downstream of the engine is identical whichever one is compiled in.
+static constexpr uint32_t SPECTRUM_LOG_SCALE_BASE = 3;
+
+template <size_t N>
+class FloatSpectrumEngine final
+{
+    static constexpr float LOG_NORM = 1.0f / 1.3862944f; // 1 / ln(1 + SPECTRUM_LOG_SCALE_BASE)
+    static_assert(SPECTRUM_LOG_SCALE_BASE == 3, "Update LOG_NORM together with SPECTRUM_LOG_SCALE_BASE");
+
+    std::array<std::complex<float>, RealFFT<N>::BUFFER_SIZE> buffer_{};
+
+  public:
+    static constexpr size_t SIZE = N;
+    static constexpr size_t SPECTRUM_SIZE = RealFFT<N>::SPECTRUM_SIZE;
+
+    void process(const WindowType window, const int32_t *samples, float *levels, const size_t count)
+    {
+        Window<N>::apply(window, samples, RealFFT<N>::samples(buffer_.data()));
+        RealFFT<N>::transform(buffer_.data());
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float re = buffer_[i].real();
+            const float im = buffer_[i].imag();
+            const float magnitude = std::sqrt(re * re + im * im);
+            levels[i] = std::log(1.0f + magnitude * SPECTRUM_LOG_SCALE_BASE) * LOG_NORM;
+        }
+    }
+};
+
+// Q15 variant: Q15 window, block floating point FFT, integer magnitude and integer log2.
+// Only the final per-bin level is converted to float.
+template <size_t N>
+class FixedSpectrumEngine final
+{
+    static constexpr size_t M = N / 2;
+
+    static constexpr std::array<cq15_t, M / 2 + 1> genSplitTwiddles()
+    {
+        std::array<cq15_t, M / 2 + 1> table{};
+        for (size_t k = 0; k <= M / 2; ++k)
+        {
+            const double angle = -2.0 * M_PI * static_cast<double>(k) / static_cast<double>(N);
+            table[k] = {
+                static_cast<q15_t>(std::lround(std::min(std::cos(angle) * 32768.0, 32767.0))),
+                static_cast<q15_t>(std::lround(std::min(std::sin(angle) * 32768.0, 32767.0))),
+            };
+        }
+        return table;
+    }
+
+    static constexpr std::array<cq15_t, M / 2 + 1> SPLIT_TWIDDLES = genSplitTwiddles();
+
+    // Turns a Q16 log2(1 + base * m) into a level: 1 / 65536 drops the Q16 scale, and 1 / 2 is
+    // 1 / log2(1 + SPECTRUM_LOG_SCALE_BASE), the normalization the float engine applies
+    static constexpr float LEVEL_SCALE = 1.0f / (2.0f * 65536.0f);
+    static_assert(SPECTRUM_LOG_SCALE_BASE == 3, "Update LEVEL_SCALE together with SPECTRUM_LOG_SCALE_BASE");
+
+    std::array<cq15_t, M> buffer_{};
+
+  public:
+    static constexpr size_t SIZE = N;
+    static constexpr size_t SPECTRUM_SIZE = M + 1;
+
+    void process(const WindowType window, const int32_t *samples, float *levels, const size_t count)
+    {
+        // cq15_t is two packed q15_t, so the buffer doubles as N interleaved real samples
+        Window<N>::applyQ15(window, samples, reinterpret_cast<q15_t *>(buffer_.data()));
+        uint32_t shift = FFTQ15<M>::transform(buffer_.data());
+
+        // The split pass adds W * odd to even, which needs the same headroom as a butterfly
+        if (FFTQ15<M>::maxComponent(buffer_.data(), M) > FFTQ15<M>::MAX_SAFE)
+        {
+            for (auto &z : buffer_)
+            {
+                z = {static_cast<q15_t>(z.re >> 1), static_cast<q15_t>(z.im >> 1)};
+            }
+            shift++;
+        }
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            int32_t re;
+            int32_t im;
+
+            if (k == 0 || k == M)
+            {
+                // DC and Nyquist are purely real
+                re = k == 0 ? buffer_[0].re + buffer_[0].im : buffer_[0].re - buffer_[0].im;
+                im = 0;
+            }
+            else
+            {
+                const cq15_t &zk = buffer_[k];
+                const cq15_t &zmk = buffer_[M - k];
+
+                // W^(M-k) = -conj(W^k) for the upper half of the spectrum
+                const cq15_t &wLow = SPLIT_TWIDDLES[k <= M / 2 ? k : M - k];
+                const int32_t wr = k <= M / 2 ? wLow.re : -wLow.re;
+                const int32_t wi = wLow.im;
+
+                const int32_t evenR = (zk.re + zmk.re) >> 1;
+                const int32_t evenI = (zk.im - zmk.im) >> 1;
+                const int32_t oddR = (zk.im + zmk.im) >> 1;
+                const int32_t oddI = -((zk.re - zmk.re) >> 1);
+
+                re = evenR + ((wr * oddR - wi * oddI + (1 << 14)) >> 15);
+                im = evenI + ((wr * oddI + wi * oddR + (1 << 14)) >> 15);
+            }
+
+            const uint32_t magnitude = isqrt32(static_cast<uint32_t>(re * re + im * im));
+
+            // 1 + base * m in Q16, where m = magnitude * 2^shift / 32768
+            const uint32_t scaled = 65536 + ((SPECTRUM_LOG_SCALE_BASE * 2 * magnitude) << shift);
+            levels[k] = static_cast<float>(log2Q16(scaled) - (16 << 16)) * LEVEL_SCALE;
+        }
+    }
+};
+
+// Build with -DTOTEM_AUDIO_FIXED_POINT to keep the per-sample analysis off the FPU
+#ifdef TOTEM_AUDIO_FIXED_POINT
+template <size_t N>
+using SpectrumEngine = FixedSpectrumEngine<N>;
+#else
+template <size_t N>
+using SpectrumEngine = FloatSpectrumEngine<N>;
+#endif
@@ -0,0 +1,250 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Mean, variance, min and max over the last N values, all O(1) per push (amortized).
+// Sums are rebuilt from the window once per wrap so float rounding cannot drift,
+// and min/max come from monotonic index queues over the same ring.
+template <typename T, size_t N>
+class WindowStats final
+{
+    static_assert(std::is_arithmetic_v<T>, "WindowStats needs an arithmetic type");
+
+    using Sum = std::conditional_t<std::is_floating_point_v<T>, float, int64_t>;
+
+    std::array<T, N> values_{};
+    size_t index_ = 0;
+    size_t count_ = 0;
+    uint64_t pushed_ = 0;
+    Sum sum_ = 0;
+    Sum sumSquares_ = 0;
+
+    // Monotonic queues of absolute push positions; front is the current min/max
+    struct Queue
+    {
+        std::array<uint64_t, N> positions{};
+        size_t head = 0;
+        size_t size = 0;
+
+        uint64_t front() const
+        {
+            return positions[head];
+        }
+
+        uint64_t back() const
+        {
+            return positions[(head + size - 1) % N];
+        }
+
+        void popFront()
+        {
+            head = (head + 1) % N;
+            size--;
+        }
+
+        void pushBack(const uint64_t position)
+        {
+            positions[(head + size) % N] = position;
+            size++;
+        }
+    };
+
+    Queue minQueue_;
+    Queue maxQueue_;
+
+    T at(const uint64_t position) const
+    {
+        return values_[position % N];
+    }
+
+  public:
+    static constexpr size_t CAPACITY = N;
+
+    void push(const T value)
+    {
+        if (count_ == N)
+        {
+            const T oldest = values_[index_];
+            sum_ -= oldest;
+            sumSquares_ -= static_cast<Sum>(oldest) * oldest;
+        }
+        else
+        {
+            count_++;
+        }
+
+        values_[index_] = value;
+        sum_ += value;
+        sumSquares_ += static_cast<Sum>(value) * value;
+
+        const uint64_t position = pushed_++;
+
+        // Drop positions that left the window, then dominated entries from the back
+        const uint64_t oldestKept = pushed_ > N ? pushed_ - N : 0;
+        while (minQueue_.size && minQueue_.front() < oldestKept)
+            minQueue_.popFront();
+        while (maxQueue_.size && maxQueue_.front() < oldestKept)
+            maxQueue_.popFront();
+        while (minQueue_.size && at(minQueue_.back()) >= value)
+            minQueue_.size--;
+        while (maxQueue_.size && at(maxQueue_.back()) <= value)
+            maxQueue_.size--;
+        minQueue_.pushBack(position);
+        maxQueue_.pushBack(position);
+
+        index_ = (index_ + 1) % N;
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            if (index_ == 0)
+            {
+                sum_ = 0;
+                sumSquares_ = 0;
+                for (const T v : values_)
+                {
+                    sum_ += v;
+                    sumSquares_ += v * v;
+                }
+            }
+        }
+    }
+
+    void clear()
+    {
+        *this = WindowStats();
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return count_;
+    }
+
+    [[nodiscard]] bool full() const
+    {
+        return count_ == N;
+    }
+
+    [[nodiscard]] float mean() const
+    {
+        return count_ ? static_cast<float>(sum_) / count_ : 0.0f;
+    }
+
+    [[nodiscard]] float variance() const
+    {
+        if (!count_)
+            return 0.0f;
+
+        const float m = mean();
+        return std::max(0.0f, static_cast<float>(sumSquares_) / count_ - m * m);
+    }
+
+    [[nodiscard]] float stddev() const
+    {
+        return std::sqrt(variance());
+    }
+
+    [[nodiscard]] T min() const
+    {
+        return count_ ? at(minQueue_.front()) : T{};
+    }
+
+    [[nodiscard]] T max() const
+    {
+        return count_ ? at(maxQueue_.front()) : T{};
+    }
+};
+
+// Order statistics over the last N values. The window is kept sorted; each push removes the
+// oldest value and inserts the new one with a binary search and a single shift of the values
+// in between, so a median or quantile read is O(1) and a push is O(log N) plus a short move.
+template <typename T, size_t N>
+class WindowMedian final
+{
+    static_assert(std::is_trivially_copyable_v<T>, "WindowMedian moves values with memmove");
+
+    std::array<T, N> values_{}; // Arrival order
+    std::array<T, N> sorted_{};
+    size_t index_ = 0;
+    size_t count_ = 0;
+
+  public:
+    static constexpr size_t CAPACITY = N;
+
+    void push(const T value)
+    {
+        T *first = sorted_.data();
+        size_t insert = std::upper_bound(first, first + count_, value) - first;
+
+        if (count_ < N)
+        {
+            std::memmove(first + insert + 1, first + insert, (count_ - insert) * sizeof(T));
+            count_++;
+        }
+        else
+        {
+            // Close the gap left by the oldest value and open one for the new value in one move
+            const size_t remove = std::lower_bound(first, first + N, values_[index_]) - first;
+            if (remove < insert)
+            {
+                insert--;
+                std::memmove(first + remove, first + remove + 1, (insert - remove) * sizeof(T));
+            }
+            else
+            {
+                std::memmove(first + insert + 1, first + insert, (remove - insert) * sizeof(T));
+            }
+        }
+
+        sorted_[insert] = value;
+        values_[index_] = value;
+        index_ = (index_ + 1) % N;
+    }
+
+    void clear()
+    {
+        index_ = 0;
+        count_ = 0;
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return count_;
+    }
+
+    [[nodiscard]] bool full() const
+    {
+        return count_ == N;
+    }
+
+    // The value at fraction q (0-1) of the sorted window, lower neighbour
+    [[nodiscard]] T quantile(const float q) const
+    {
+        if (!count_)
+            return T{};
+
+        return sorted_[std::min(count_ - 1, static_cast<size_t>(q * (count_ - 1) + 0.5f))];
+    }
+
+    // Mean of the two middle values for even sizes
+    [[nodiscard]] T median() const
+    {
+        if (!count_)
+            return T{};
+
+        return (sorted_[(count_ - 1) / 2] + sorted_[count_ / 2]) / 2;
+    }
+
+    [[nodiscard]] T min() const
+    {
+        return count_ ? sorted_[0] : T{};
+    }
+
+    [[nodiscard]] T max() const
+    {
+        return count_ ? sorted_[count_ - 1] : T{};
+    }
+};
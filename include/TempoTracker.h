@@ -0,0 +1,177 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+
+#include "RingBuffer.h"
+
+static constexpr float TEMPO_MIN_BPM = 60.0f;
+static constexpr float TEMPO_MAX_BPM = 180.0f;
+
+// Tempo and beat phase from the onset envelope. A bank of leaky autocorrelation (comb) filters,
+// one per candidate period from TEMPO_MAX_BPM to TEMPO_MIN_BPM, is weighted by a tempo prior
+// around PRIOR_BPM to settle octave ambiguity. A clock runs at the winning period, and the
+// envelope is accumulated as a leaky phasor at the clock's phase: its angle is where in the
+// beat the strongest onsets fall, so kicks outweigh off-beat hats. The beat clock is the
+// clock shifted by that angle, which lets beats be anticipated instead of reported after
+// detection. TMaxLag is the longest period in analysis frames.
+template <size_t TMaxLag>
+class TempoTracker final
+{
+  public:
+    static constexpr float PRIOR_BPM = 120.0f;
+    static constexpr float PRIOR_OCTAVES = 1.0f;  // Width of the log-normal tempo prior
+    static constexpr float MEMORY_SECONDS = 4.0f; // Time constant of the comb filters
+    static constexpr float MEAN_SECONDS = 1.0f;   // Envelope baseline time constant
+    static constexpr float PHASE_MEMORY_SECONDS = 4.0f;
+    static constexpr float PERIOD_SMOOTHING = 0.05f;
+
+  private:
+    RingBuffer<float, TMaxLag + 1> envelope_;
+    std::array<float, TMaxLag + 1> comb_{};
+    std::array<float, TMaxLag + 1> prior_{};
+
+    float frameSeconds_ = 0.0f;
+    size_t minLag_ = 1;
+    size_t maxLag_ = 1;
+    float decay_ = 0.0f;
+    float phaseDecay_ = 0.0f;
+    float meanRate_ = 0.0f;
+
+    float mean_ = 0.0f;
+    float energy_ = 0.0f;
+    float period_ = 0.0f; // Analysis frames per beat
+    float clock_ = 0.0f;  // Free-running phase, 0-1
+    std::complex<float> phasor_{};
+    float phase_ = 0.0f; // Beat phase, 0-1 through the current beat
+    float sinceBeat_ = 0.0f;
+    float confidence_ = 0.0f;
+    uint32_t beats_ = 0;
+
+  public:
+    // Sets the analysis frame period and restarts tracking
+    void configure(const float frameSeconds)
+    {
+        frameSeconds_ = frameSeconds;
+        minLag_ = std::max<size_t>(1, static_cast<size_t>(60.0f / (TEMPO_MAX_BPM * frameSeconds)));
+        maxLag_ = std::min(TMaxLag, static_cast<size_t>(std::ceil(60.0f / (TEMPO_MIN_BPM * frameSeconds))));
+        decay_ = std::exp(-frameSeconds / MEMORY_SECONDS);
+        phaseDecay_ = std::exp(-frameSeconds / PHASE_MEMORY_SECONDS);
+        meanRate_ = 1.0f - std::exp(-frameSeconds / MEAN_SECONDS);
+
+        for (size_t lag = minLag_; lag <= maxLag_; ++lag)
+        {
+            const float octaves = std::log2(60.0f / (lag * frameSeconds) / PRIOR_BPM) / PRIOR_OCTAVES;
+            prior_[lag] = std::exp(-0.5f * octaves * octaves);
+        }
+
+        envelope_.clear();
+        comb_.fill(0.0f);
+        mean_ = 0.0f;
+        energy_ = 0.0f;
+        period_ = 60.0f / (PRIOR_BPM * frameSeconds);
+        clock_ = 0.0f;
+        phasor_ = {};
+        phase_ = 0.0f;
+        sinceBeat_ = 0.0f;
+        confidence_ = 0.0f;
+    }
+
+    // Called once per analysis frame with the onset envelope value (full-band spectral flux)
+    void update(const float flux)
+    {
+        // Rectified rise above the slow baseline, so only onsets correlate
+        mean_ += (flux - mean_) * meanRate_;
+        const float rise = flux - mean_;
+        const float e = std::max(0.0f, rise);
+        envelope_.push(e);
+        energy_ = energy_ * decay_ + e * e;
+
+        size_t best = minLag_;
+        float bestScore = -1.0f;
+        for (size_t lag = minLag_; lag <= maxLag_; ++lag)
+        {
+            comb_[lag] = comb_[lag] * decay_ + e * envelope_.newest(lag);
+            if (const float score = comb_[lag] * prior_[lag]; score > bestScore)
+            {
+                bestScore = score;
+                best = lag;
+            }
+        }
+
+        // Parabolic interpolation for a sub-frame period
+        float period = static_cast<float>(best);
+        if (best > minLag_ && best < maxLag_)
+        {
+            const float before = comb_[best - 1] * prior_[best - 1];
+            const float after = comb_[best + 1] * prior_[best + 1];
+            if (const float curvature = before - 2.0f * bestScore + after; curvature < 0.0f)
+            {
+                period += 0.5f * (before - after) / curvature;
+            }
+        }
+
+        if (energy_ > 0.0f)
+        {
+            period_ += (period - period_) * PERIOD_SMOOTHING;
+            confidence_ = std::clamp(comb_[best] / energy_, 0.0f, 1.0f);
+        }
+
+        // Advance the clock and find where in its cycle the envelope peaks
+        clock_ += 1.0f / period_;
+        clock_ -= std::floor(clock_);
+        constexpr float twoPi = 2.0f * static_cast<float>(M_PI);
+
+        // The unrectified rise has no DC part, so a steady noise floor cannot bias the angle
+        phasor_ = phasor_ * phaseDecay_ + rise * std::polar(1.0f, twoPi * clock_);
+
+        const float offset = std::arg(phasor_) / twoPi;
+        float phase = clock_ - offset;
+        phase -= std::floor(phase);
+
+        // A beat is the beat phase wrapping; offset corrections cannot count one twice
+        sinceBeat_ += 1.0f;
+        if (phase < phase_ - 0.5f && sinceBeat_ > 0.5f * period_)
+        {
+            beats_++;
+            sinceBeat_ = 0.0f;
+        }
+        phase_ = phase;
+    }
+
+    [[nodiscard]] float bpm() const
+    {
+        return 60.0f / (period_ * frameSeconds_);
+    }
+
+    [[nodiscard]] float periodSeconds() const
+    {
+        return period_ * frameSeconds_;
+    }
+
+    [[nodiscard]] float phase() const
+    {
+        return phase_;
+    }
+
+    // Seconds from the end of the last frame until the next predicted beat
+    [[nodiscard]] float secondsToNextBeat() const
+    {
+        return (1.0f - phase_) * period_ * frameSeconds_;
+    }
+
+    // Share of the onset envelope energy explained by the chosen period, 0-1
+    [[nodiscard]] float confidence() const
+    {
+        return confidence_;
+    }
+
+    // Beats the clock has completed
+    [[nodiscard]] uint32_t beats() const
+    {
+        return beats_;
+    }
+};
@@ -0,0 +1,62 @@
+﻿#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Wait-free single-producer / single-consumer triple buffer.
+// The producer fills back() and publish()es it; the consumer calls acquire() and reads front().
+// Neither side ever blocks, and the consumer always sees one complete snapshot, never a mix of two.
+template <typename T>
+class TripleBuffer
+{
+    static constexpr uint8_t INDEX_MASK = 0x03;
+    static constexpr uint8_t FRESH = 0x04;
+
+    std::array<T, 3> slots_{};
+    std::array<uint32_t, 3> sequences_{};
+
+    // Slot shared between the two sides, with FRESH set while it holds an unread publish
+    std::atomic<uint8_t> middle_{1};
+    uint8_t back_ = 0;  // Producer-owned
+    uint8_t front_ = 2; // Consumer-owned
+    uint32_t published_ = 0;
+
+  public:
+    // Producer: slot to fill before the next publish()
+    T &back()
+    {
+        return slots_[back_];
+    }
+
+    // Producer: hands back() to the consumer and takes the old shared slot as the new back()
+    void publish()
+    {
+        sequences_[back_] = ++published_;
+        back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Consumer: swaps in the newest published slot, returns false if nothing new was published
+    bool acquire()
+    {
+        if (!(middle_.load(std::memory_order_relaxed) & FRESH))
+        {
+            return false;
+        }
+
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    // Consumer: latest acquired snapshot
+    [[nodiscard]] const T &front() const
+    {
+        return slots_[front_];
+    }
+
+    // Consumer: publish number of front(), 0 before the first publish
+    [[nodiscard]] uint32_t frontSequence() const
+    {
+        return sequences_[front_];
+    }
+};
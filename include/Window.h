@@ -0,0 +1,130 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "FixedPoint.h"
+
+enum class WindowType : uint8_t
+{
+    HANN,
+    HAMMING,
+    BLACKMAN_HARRIS,
+    FLAT_TOP,
+};
+
+static constexpr size_t WINDOW_TYPE_COUNT = 4;
+
+inline const char *windowTypeName(const WindowType type)
+{
+    switch (type)
+    {
+        case WindowType::HANN: return "hann";
+        case WindowType::HAMMING: return "hamming";
+        case WindowType::BLACKMAN_HARRIS: return "blackman-harris";
+        case WindowType::FLAT_TOP: return "flat-top";
+        default: return "unknown";
+    }
+}
+
+inline bool parseWindowType(const char *name, WindowType &type)
+{
+    for (size_t i = 0; i < WINDOW_TYPE_COUNT; ++i)
+    {
+        if (std::strcmp(name, windowTypeName(static_cast<WindowType>(i))) == 0)
+        {
+            type = static_cast<WindowType>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Compile-time window tables for an N-sample analysis frame.
+// Each coefficient is pre-multiplied by the 1/32768 sample scale, so turning a raw 32-bit
+// I2S word into a windowed float is a shift, a convert and a single multiply.
+template <size_t N>
+class Window final
+{
+    static constexpr double SAMPLE_SCALE = 1.0 / 32768.0;
+
+    // Generalized cosine window: a0 - a1 cos(x) + a2 cos(2x) - a3 cos(3x) + a4 cos(4x)
+    static constexpr std::array<float, N> genCosineSum(
+        const double a0,
+        const double a1,
+        const double a2 = 0.0,
+        const double a3 = 0.0,
+        const double a4 = 0.0)
+    {
+        std::array<float, N> table{};
+        for (size_t i = 0; i < N; ++i)
+        {
+            const double x = 2.0 * M_PI * static_cast<double>(i) / static_cast<double>(N - 1);
+            const double w = a0 - a1 * std::cos(x) + a2 * std::cos(2.0 * x) - a3 * std::cos(3.0 * x) +
+                             a4 * std::cos(4.0 * x);
+            table[i] = static_cast<float>(w * SAMPLE_SCALE);
+        }
+        return table;
+    }
+
+    static constexpr std::array<std::array<float, N>, WINDOW_TYPE_COUNT> TABLES = {
+        genCosineSum(0.5, 0.5),
+        genCosineSum(0.54, 0.46),
+        genCosineSum(0.35875, 0.48829, 0.14128, 0.01168),
+        genCosineSum(0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368),
+    };
+
+    // Q15 copies of the float tables with the sample scale removed again
+    static constexpr std::array<q15_t, N> genQ15(const std::array<float, N> &table)
+    {
+        std::array<q15_t, N> q15{};
+        for (size_t i = 0; i < N; ++i)
+        {
+            const double w = static_cast<double>(table[i]) / SAMPLE_SCALE;
+            q15[i] = static_cast<q15_t>(std::lround(std::clamp(w * 32768.0, -32768.0, 32767.0)));
+        }
+        return q15;
+    }
+
+    static constexpr std::array<std::array<q15_t, N>, WINDOW_TYPE_COUNT> TABLES_Q15 = {
+        genQ15(TABLES[0]),
+        genQ15(TABLES[1]),
+        genQ15(TABLES[2]),
+        genQ15(TABLES[3]),
+    };
+
+  public:
+    [[nodiscard]] static const std::array<float, N> &table(const WindowType type)
+    {
+        return TABLES[static_cast<size_t>(type)];
+    }
+
+    [[nodiscard]] static const std::array<q15_t, N> &tableQ15(const WindowType type)
+    {
+        return TABLES_Q15[static_cast<size_t>(type)];
+    }
+
+    // Fused sample conversion, >>16 scaling and windowing of N raw I2S words
+    static void apply(const WindowType type, const int32_t *in, float *out)
+    {
+        const float *w = table(type).data();
+        for (size_t i = 0; i < N; ++i)
+        {
+            out[i] = static_cast<float>(in[i] >> 16) * w[i];
+        }
+    }
+
+    // Fixed-point variant writing Q15 samples
+    static void applyQ15(const WindowType type, const int32_t *in, q15_t *out)
+    {
+        const q15_t *w = tableQ15(type).data();
+        for (size_t i = 0; i < N; ++i)
+        {
+            out[i] = static_cast<q15_t>(((in[i] >> 16) * w[i] + (1 << 14)) >> 15);
+        }
+    }
+};
@@ -13,9 +13,13 @@
 
 #include <GFX_Layer.hpp>
 #include <GFX_Lite.h>
+#include <algorithm>
 #include <atomic>
 #include <cstring>
+#include <mutex>
 
+#include "FramePresenter.h"
+#include "FrameScheduler.h"
 #include "MatrixGfx.h"
 #include "MatrixNoise.h"
 #include "Microphone.h"
@@ -93,6 +97,165 @@
 static Microphone mic;
 static std::unique_ptr<MatrixPanel_I2S_DMA> dmaDisplay;
 static std::atomic<uint8_t> globalBrightness{200};
+// The canvas is shown rotated 90 degrees clockwise on the panel
+static constexpr PanelLayout PANEL_LAYOUT{PanelRotation::ROTATE_90};
+static FramePresenter<PANEL_LAYOUT> presenter;
+static FrameScheduler scheduler;
+static LatencyStats<256> latencyStats;
+static std::mutex latencyMutex; // Recorded on the present thread, reported from the loop and web server
+
+// The panel is repainted in full after a brightness change, since unchanged spans are otherwise never
+// rewritten at the new level
+static void setBrightness(const uint8_t value)
+{
+    globalBrightness.store(value);
+    presenter.invalidate();
+}
+
+static LatencyStats<256>::Summary summarizeLatency(const LatencyStage stage)
+{
+    std::lock_guard lock(latencyMutex);
+    return latencyStats.summarize(stage);
+}
+
+static void printLatencyReport()
+{
+    Serial.printf("Audio analysis pass: %u us\n", mic.getProcessingTimeUs());
+    Serial.printf(
+        "Panel present pass: %u us, %u pixels pushed, %u skipped as unchanged\n",
+        presenter.getPresentTimeUs(),
+        presenter.getPushedPixels(),
+        presenter.getSkippedPixels());
+    const auto &pacing = scheduler.stats();
+    Serial.printf(
+        "Frame pacing: %u fps target, %u frames, %u overruns, last slack %d us, min slack %d us\n",
+        pacing.targetFps,
+        pacing.frames,
+        pacing.overruns,
+        pacing.lastSlackUs,
+        pacing.minSlackUs);
+    Serial.printf("%-10s %6s %8s %8s %8s %8s %8s\n", "stage", "n", "min", "p50", "p90", "p99", "max");
+    for (size_t i = 0; i < LATENCY_STAGE_COUNT; ++i)
+    {
+        const auto stage = static_cast<LatencyStage>(i);
+        const auto summary = summarizeLatency(stage);
+        Serial.printf(
+            "%-10s %6u %8u %8u %8u %8u %8u\n",
+            latencyStageName(stage),
+            summary.count,
+            summary.minUs,
+            summary.p50Us,
+            summary.p90Us,
+            summary.p99Us,
+            summary.maxUs);
+    }
+}
+
+// One line per pattern, worst p99 render time first
+static void printProfileReport()
+{
+    auto patterns = Pattern::Profiler.snapshot();
+    std::ranges::sort(
+        patterns,
+        [](const auto &a, const auto &b)
+        {
+            const auto render = static_cast<size_t>(RenderPhase::RENDER);
+            return a.second[render].p99Us > b.second[render].p99Us;
+        });
+
+    Serial.printf("Frame budget: %u us\n", scheduler.periodUs());
+    Serial.printf("%-32s %-11s %7s %7s %7s %7s %7s\n", "pattern", "phase", "n", "mean", "p50", "p99", "max");
+    for (const auto &[id, phases] : patterns)
+    {
+        for (size_t i = 0; i < RENDER_PHASE_COUNT; ++i)
+        {
+            const auto &summary = phases[i];
+            if (summary.count == 0)
+                continue;
+
+            Serial.printf(
+                "%-32s %-11s %7u %7u %7u %7u %7u\n",
+                id.c_str(),
+                renderPhaseName(static_cast<RenderPhase>(i)),
+                summary.count,
+                summary.meanUs,
+                summary.p50Us,
+                summary.p99Us,
+                summary.maxUs);
+        }
+    }
+}
+
+// Longest serial command line; longer lines are dropped whole
+static constexpr size_t SERIAL_LINE_MAX = 64;
+
+static void handleSerialCommands()
+{
+    static String line;
+    static bool overlong = false;
+
+    while (Serial.available())
+    {
+        const char c = static_cast<char>(Serial.read());
+        if (c != '\n' && c != '\r')
+        {
+            if (line.length() < SERIAL_LINE_MAX)
+                line += c;
+            else
+                overlong = true;
+            continue;
+        }
+
+        line.trim();
+        if (overlong)
+        {
+            Serial.printf("Command longer than %u characters ignored\n", static_cast<unsigned>(SERIAL_LINE_MAX));
+            overlong = false;
+        }
+        else if (line == "latency")
+        {
+            printLatencyReport();
+        }
+        else if (line == "latency reset")
+        {
+            std::lock_guard lock(latencyMutex);
+            latencyStats.clear();
+            scheduler.resetStats();
+            Serial.println("Latency stats cleared");
+        }
+        else if (line == "refresh")
+        {
+            presenter.invalidate();
+            Serial.println("Panel repaint requested");
+        }
+        else if (line == "profile")
+        {
+            printProfileReport();
+        }
+        else if (line == "profile reset")
+        {
+            Pattern::Profiler.clear();
+            Serial.println("Render profile cleared");
+        }
+        else if (line.startsWith("fps "))
+        {
+            if (scheduler.setTargetFps(line.substring(4).toInt()))
+            {
+                Serial.printf("Target frame rate set to %u fps\n", scheduler.getTargetFps());
+            }
+            else
+            {
+                Serial.printf(
+                    "Target frame rate must be %u-%u fps\n", FrameScheduler::FPS_MIN, FrameScheduler::FPS_MAX);
+            }
+        }
+        else if (!line.isEmpty())
+        {
+            Serial.printf("Unknown command: %s\n", line.c_str());
+        }
+        line = "";
+    }
+}
 
 #ifdef TOTEM_USE_WIFI
 enum class TotemState
@@ -112,9 +275,14 @@ static constexpr byte DNS_PORT = 53;
 static auto commandEndpoint = new AsyncCallbackJsonWebHandler("/command");
 static auto brightnessEndpoint = new AsyncCallbackJsonWebHandler("/brightness");
 static auto getPatternIdsEndpoint = new AsyncCallbackJsonWebHandler("/patterns");
+static auto audioEndpoint = new AsyncCallbackJsonWebHandler("/audio");
+static auto latencyEndpoint = new AsyncCallbackJsonWebHandler("/latency");
+static auto profileEndpoint = new AsyncCallbackJsonWebHandler("/profile");
 
 static constexpr auto MATRIX_BUFFER_SIZE = MATRIX_WIDTH * MATRIX_HEIGHT * sizeof(uint32_t);
 static std::atomic<uint16_t> currentGifFrameIdx = 0;
+static uint32_t gifFrameElapsedUs = 0;
+static constexpr uint32_t GIF_FRAME_US = 60000;
 static std::vector<uint8_t> gif;
 static std::vector<uint8_t> gifBuf;
 static constexpr std::array<size_t, 256> DRAM_ATTR GIF_GAMMA = GenGammaTable<1.8f, 256, 255>();
@@ -134,7 +302,7 @@ static void setupEndpoints()
             {
                 std::lock_guard lock(stateMutex);
                 currentTotemState.store(TotemState::MUSIC);
-                globalBrightness.store(200);
+                setBrightness(200);
                 request->send(200);
             }
             else if (cmd == "pattern")
@@ -152,6 +320,17 @@ static void setupEndpoints()
                     request->send(400, "text/plain", "Unknown pattern");
                 }
             }
+            else if (cmd == "fps")
+            {
+                if (scheduler.setTargetFps(json["value"].as<uint32_t>()))
+                {
+                    request->send(200);
+                }
+                else
+                {
+                    request->send(400, "text/plain", "Frame rate out of range");
+                }
+            }
             else
             {
                 request->send(400, "text/plain", "Unknown command");
@@ -165,7 +344,7 @@ static void setupEndpoints()
         [](AsyncWebServerRequest *request, const JsonVariant &json)
         {
             std::lock_guard lock(stateMutex);
-            globalBrightness.store(json["value"]);
+            setBrightness(json["value"]);
             request->send(200);
         });
     server.addHandler(brightnessEndpoint);
@@ -187,6 +366,145 @@ static void setupEndpoints()
         });
     server.addHandler(getPatternIdsEndpoint);
 
+    // Audio analysis settings endpoint
+    audioEndpoint->setMethod(HTTP_POST);
+    audioEndpoint->onRequest(
+        [](AsyncWebServerRequest *request, const JsonVariant &json)
+        {
+            // Validate every field before applying any, so a bad request changes nothing
+            const bool hasWindow = !json["window"].isNull();
+            WindowType window{};
+            if (hasWindow &&
+                !(json["window"].is<const char *>() && parseWindowType(json["window"].as<const char *>(), window)))
+            {
+                request->send(400, "text/plain", "Unknown window");
+                return;
+            }
+
+            const bool hasBands = !json["bands"].isNull();
+            BandScale scale{};
+            if (hasBands &&
+                !(json["bands"].is<const char *>() && parseBandScale(json["bands"].as<const char *>(), scale)))
+            {
+                request->send(400, "text/plain", "Unknown band scale");
+                return;
+            }
+
+            const bool hasHop = !json["hop"].isNull();
+            if (hasHop && !(json["hop"].is<size_t>() && Microphone::isValidHopSize(json["hop"].as<size_t>())))
+            {
+                request->send(400, "text/plain", "Invalid hop size");
+                return;
+            }
+
+            if (hasWindow)
+            {
+                mic.setWindow(window);
+                Serial.printf("Audio window set to %s\n", windowTypeName(window));
+            }
+
+            if (hasBands)
+            {
+                mic.setBandScale(scale);
+                Serial.printf("Audio band scale set to %s\n", bandScaleName(scale));
+            }
+
+            if (hasHop)
+            {
+                mic.setHopSize(json["hop"].as<size_t>());
+                Serial.printf("Audio hop size set to %u\n", static_cast<unsigned>(mic.getHopSize()));
+            }
+
+            request->send(200);
+        });
+    server.addHandler(audioEndpoint);
+
+    // Audio-to-panel latency report endpoint
+    latencyEndpoint->setMethod(HTTP_GET);
+    latencyEndpoint->onRequest(
+        [](AsyncWebServerRequest *request, const JsonVariant &json)
+        {
+            JsonDocument doc;
+            doc["processingUs"] = mic.getProcessingTimeUs();
+            doc["presentUs"] = presenter.getPresentTimeUs();
+            doc["pushedPixels"] = presenter.getPushedPixels();
+            doc["skippedPixels"] = presenter.getSkippedPixels();
+
+            JsonArray buckets = doc["bucketEdgesUs"].to<JsonArray>();
+            for (const auto edge : decltype(latencyStats)::BUCKET_EDGES_US)
+            {
+                buckets.add(edge);
+            }
+
+            JsonObject stages = doc["stages"].to<JsonObject>();
+            for (size_t i = 0; i < LATENCY_STAGE_COUNT; ++i)
+            {
+                const auto stage = static_cast<LatencyStage>(i);
+                const auto summary = summarizeLatency(stage);
+                JsonObject entry = stages[latencyStageName(stage)].to<JsonObject>();
+                entry["count"] = summary.count;
+                entry["minUs"] = summary.minUs;
+                entry["p50Us"] = summary.p50Us;
+                entry["p90Us"] = summary.p90Us;
+                entry["p99Us"] = summary.p99Us;
+                entry["maxUs"] = summary.maxUs;
+                JsonArray histogram = entry["histogram"].to<JsonArray>();
+                for (const auto count : summary.histogram)
+                {
+                    histogram.add(count);
+                }
+            }
+
+            String jsonString;
+            serializeJson(doc, jsonString);
+            request->send(200, "application/json", jsonString);
+        });
+    server.addHandler(latencyEndpoint);
+
+    // Per-pattern render time endpoint
+    profileEndpoint->setMethod(HTTP_GET);
+    profileEndpoint->onRequest(
+        [](AsyncWebServerRequest *request, const JsonVariant &json)
+        {
+            JsonDocument doc;
+            doc["frameBudgetUs"] = scheduler.periodUs();
+
+            JsonArray buckets = doc["bucketEdgesUs"].to<JsonArray>();
+            for (const auto edge : RenderProfiler::BUCKET_EDGES_US)
+            {
+                buckets.add(edge);
+            }
+
+            JsonObject patterns = doc["patterns"].to<JsonObject>();
+            for (const auto &[id, phases] : Pattern::Profiler.snapshot())
+            {
+                JsonObject pattern = patterns[id].to<JsonObject>();
+                for (size_t i = 0; i < RENDER_PHASE_COUNT; ++i)
+                {
+                    const auto &summary = phases[i];
+                    if (summary.count == 0)
+                        continue;
+
+                    JsonObject entry = pattern[renderPhaseName(static_cast<RenderPhase>(i))].to<JsonObject>();
+                    entry["count"] = summary.count;
+                    entry["meanUs"] = summary.meanUs;
+                    entry["p50Us"] = summary.p50Us;
+                    entry["p99Us"] = summary.p99Us;
+                    entry["maxUs"] = summary.maxUs;
+                    JsonArray histogram = entry["histogram"].to<JsonArray>();
+                    for (const auto count : summary.histogram)
+                    {
+                        histogram.add(count);
+                    }
+                }
+            }
+
+            String jsonString;
+            serializeJson(doc, jsonString);
+            request->send(200, "application/json", jsonString);
+        });
+    server.addHandler(profileEndpoint);
+
     // GIF upload endpoint
     server.on(
         "/gif",
@@ -201,7 +519,7 @@ static void setupEndpoints()
                 gifBuf.size() / MATRIX_BUFFER_SIZE);
             currentGifFrameIdx.store(0);
             gif = std::move(gifBuf);
-            globalBrightness.store(80);
+            setBrightness(80);
             currentTotemState.store(TotemState::GIF);
         },
         nullptr,
@@ -309,6 +627,17 @@ void setup()
     }
     Serial.println("Started DMA Driver");
 
+    presenter.start(
+        dmaDisplay.get(),
+        [](const decltype(presenter)::Frame &frame, const uint32_t presentedUs)
+        {
+            if (frame.freshAudio)
+            {
+                std::lock_guard lock(latencyMutex);
+                latencyStats.record(frame.timestamps, frame.renderedUs, presentedUs);
+            }
+        });
+
     mic.start();
     delay(100);
     mic.getContext(Pattern::Audio);
@@ -390,8 +719,9 @@ void setup()
 
 static uint32_t ms = 0;
 static uint32_t fps = 0;
+static uint32_t presentedAtLastReport = 0;
 
-void loop()
+static void renderFrame()
 {
 #ifdef TOTEM_USE_WIFI
     dnsServer.processNextRequest();
@@ -399,8 +729,8 @@ void loop()
 #endif
 
     Pattern::clearAllGfx();
-    mic.getContext(Pattern::Audio);
-    Pattern::updateBpmOscillators(Pattern::Audio.bpm);
+    const bool freshAudio = mic.getContext(Pattern::Audio);
+    Pattern::Beat.update(micros(), Pattern::Audio);
     random16_set_seed(UINT16_MAX * Pattern::Audio.energy64f / 63.0f);
 
 #ifdef TOTEM_USE_WIFI
@@ -427,8 +757,11 @@ void loop()
                 }
             }
 
-            currentGifFrameIdx = (currentGifFrameIdx + 1) % (gif.size() / MATRIX_BUFFER_SIZE);
-            delay(60);
+            // Advance at the GIF's own frame rate whatever the render rate
+            gifFrameElapsedUs += Pattern::FrameDeltaUs;
+            const size_t gifFrames = gif.size() / MATRIX_BUFFER_SIZE;
+            currentGifFrameIdx = (currentGifFrameIdx + gifFrameElapsedUs / GIF_FRAME_US) % gifFrames;
+            gifFrameElapsedUs %= GIF_FRAME_US;
         }
         break;
         case TotemState::MUSIC:
@@ -439,7 +772,7 @@ void loop()
         case TotemState::PATTERN:
         {
             if (patternState)
-                patternState->render();
+                patternState->profiledRender();
         }
         break;
     }
@@ -447,24 +780,42 @@ void loop()
     Registry::get(MusicPlaylist::ID)->render();
 #endif
 
-    dmaDisplay->setBrightness8(globalBrightness.load());
-    for (int16_t y = 0; y < dmaDisplay->height(); ++y)
-    {
-        for (int16_t x = 0; x < dmaDisplay->width(); ++x)
-        {
-            // Rotate 90 degrees clockwise
-            const int16_t gfx_x = y;
-            const int16_t gfx_y = MATRIX_WIDTH - 1 - x;
-            const CRGB &led = Pattern::Gfx(gfx_x, gfx_y) + Pattern::GfxBkg(gfx_x, gfx_y);
-            dmaDisplay->drawPixelRGB888(x, y, led.r, led.g, led.b);
-        }
-    }
+    // Compose the layers into the next frame; the present thread pushes it to the panel while the
+    // following frame renders
+    auto &frame = presenter.back();
+    presenter.compose(Pattern::Gfx.elements(), Pattern::GfxBkg.elements(), frame);
+    frame.brightness = globalBrightness.load();
+    frame.freshAudio = freshAudio;
+    frame.timestamps = Pattern::Audio.timestamps;
+    frame.renderedUs = esp_timer_get_time();
+    presenter.publish();
 
     fps++;
     if (millis() - ms > 1000)
     {
-        Serial.printf("FPS: %d\tBPM: %d\tTB: %d\n", fps, Pattern::Audio.bpm, Pattern::Audio.totalBeats);
+        const uint32_t presented = presenter.getPresentedFrames();
+        Serial.printf(
+            "FPS: %d (presented %u)\tBPM: %d\tTB: %d\n",
+            fps,
+            presented - presentedAtLastReport,
+            Pattern::Audio.bpm,
+            Pattern::Audio.totalBeats);
+        presentedAtLastReport = presented;
         ms = millis();
         fps = 0;
     }
 }
+
+void loop()
+{
+    Pattern::FrameDeltaUs = scheduler.beginFrame(esp_timer_get_time());
+    Pattern::FramePeriodUs = scheduler.periodUs();
+
+    renderFrame();
+
+    scheduler.endFrame(esp_timer_get_time());
+
+    // Out of the frame and the state lock: reports can take a while to print
+    handleSerialCommands();
+    scheduler.idle();
+}
@@ -11,13 +11,13 @@ class AudioBreathingMandalaPattern final : public Pattern
     uint16_t baseScale = 6000;
     uint16_t breatheAmplitude = 4000;
     uint8_t breatheSpeed = 2;
-    uint8_t breathePhase = 0;
+    FrameCounter<uint8_t> breathePhase = 0;
 
     // Visual parameters
     uint8_t energySmoothing = 180;
     uint8_t lastEnergyLevel = 0;
     uint8_t morphSpeed = 150;
-    uint8_t colorShift = 0;
+    FrameCounter<uint8_t> colorShift = 0;
     uint8_t colorShiftSpeed = 1;
 
     // Audio reactivity
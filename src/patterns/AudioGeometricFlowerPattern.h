@@ -6,12 +6,12 @@
 class AudioGeometricFlowerPattern final : public Pattern
 {
     uint8_t petalCount = 8;
-    uint8_t rotation = 0;
-    uint8_t colorOffset = 0;
+    FrameCounter<uint8_t> rotation = 0;
+    FrameCounter<uint8_t> colorOffset = 0;
     uint8_t petalLength = 16;
     uint8_t centerRadius = 4;
     uint8_t rotationSpeed = 1;
-    uint8_t pulsePhase = 0;
+    FrameCounter<uint8_t> pulsePhase = 0;
     bool clockwise = true;
     uint8_t petalWidth = 3;
 
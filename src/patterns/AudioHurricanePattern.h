@@ -5,8 +5,8 @@
 
 class AudioHurricanePattern final : public Pattern
 {
-    uint8_t hurricaneRotation = 0;
-    uint8_t colorOffset = 0;
+    FrameCounter<uint8_t> hurricaneRotation = 0;
+    FrameCounter<uint8_t> colorOffset = 0;
     uint8_t eyeSize = 6;
     uint8_t numArms = 8;
 
@@ -26,10 +26,9 @@ class AudioLavaLampPattern final : public Pattern
     uint8_t blob_density = 4;
 
     // Audio response
-    uint8_t audio_sensitivity = 6;
     uint8_t bass_boost = 2;
     uint8_t energy_threshold = 60;
-    uint8_t spawn_rate = 3;
+    uint8_t spawn_rate = 2; // Blobs per kick
 
     // Pattern variations
     bool rising_mode = true;
@@ -50,10 +49,9 @@ class AudioLavaLampPattern final : public Pattern
         fade_amount = random8(240, 250);
         gravity_strength = random8(1, 3);
         blob_density = random8(3, 6);
-        audio_sensitivity = random8(4, 8);
         bass_boost = random8(1, 4);
         energy_threshold = random8(40, 100);
-        spawn_rate = random8(2, 5);
+        spawn_rate = random8(1, 4);
 
         rising_mode = random8(4) > 0; // 75% chance
         merge_blobs = random8(2);
@@ -67,6 +65,47 @@ class AudioLavaLampPattern final : public Pattern
         temperature_zones = random8(2, 5);
     }
 
+    void spawnBlob(const uint8_t audio_index, const uint8_t intensity)
+    {
+        // Find inactive blob to spawn
+        for (uint8_t b = 0; b < MAX_BLOBS; b++)
+        {
+            if (!blob_active[b])
+            {
+                blob_active[b] = true;
+                blob_audio_bin[b] = audio_index;
+
+                // Spawn position based on flow direction
+                if (flow_direction == 0) // upward
+                {
+                    blob_x[b] = random8(MATRIX_WIDTH);
+                    blob_y[b] = MATRIX_HEIGHT - 1;
+                    blob_vy[b] = -(1 + (intensity >> 6));
+                    blob_vx[b] = random8(3) - 1;
+                }
+                else if (flow_direction == 1) // downward
+                {
+                    blob_x[b] = random8(MATRIX_WIDTH);
+                    blob_y[b] = 0;
+                    blob_vy[b] = 1 + (intensity >> 6);
+                    blob_vx[b] = random8(3) - 1;
+                }
+                else // sideways
+                {
+                    blob_x[b] = 0;
+                    blob_y[b] = random8(MATRIX_HEIGHT);
+                    blob_vx[b] = 1 + (intensity >> 6);
+                    blob_vy[b] = random8(3) - 1;
+                }
+
+                blob_size[b] = 2 + (intensity >> 5);
+                blob_hue[b] = base_hue + (audio_index << 2);
+                blob_life[b] = 255;
+                break;
+            }
+        }
+    }
+
   public:
     static constexpr auto ID = "Audio Lava Lamp";
 
@@ -105,50 +144,23 @@ class AudioLavaLampPattern final : public Pattern
         // Update base hue
         base_hue += hue_speed;
 
-        // Spawn new blobs based on audio
-        for (uint8_t i = 0; i < spawn_rate; i++)
+        // Spawn new blobs on percussive hits: kicks rise in bulk, snares and hats add smaller ones
+        if (Audio.kick.hit)
         {
-            uint8_t audio_index = i * (BINS / spawn_rate);
-            if (Audio.heights8[audio_index] > (255 / audio_sensitivity))
+            for (uint8_t i = 0; i < spawn_rate; i++)
             {
-                // Find inactive blob to spawn
-                for (uint8_t b = 0; b < MAX_BLOBS; b++)
-                {
-                    if (!blob_active[b])
-                    {
-                        blob_active[b] = true;
-                        blob_audio_bin[b] = audio_index;
+                spawnBlob(Audio.kick.band, Audio.kick.strength);
+            }
+        }
 
-                        // Spawn position based on flow direction
-                        if (flow_direction == 0) // upward
-                        {
-                            blob_x[b] = random8(MATRIX_WIDTH);
-                            blob_y[b] = MATRIX_HEIGHT - 1;
-                            blob_vy[b] = -(1 + (Audio.heights8[audio_index] >> 6));
-                            blob_vx[b] = random8(3) - 1;
-                        }
-                        else if (flow_direction == 1) // downward
-                        {
-                            blob_x[b] = random8(MATRIX_WIDTH);
-                            blob_y[b] = 0;
-                            blob_vy[b] = 1 + (Audio.heights8[audio_index] >> 6);
-                            blob_vx[b] = random8(3) - 1;
-                        }
-                        else // sideways
-                        {
-                            blob_x[b] = 0;
-                            blob_y[b] = random8(MATRIX_HEIGHT);
-                            blob_vx[b] = 1 + (Audio.heights8[audio_index] >> 6);
-                            blob_vy[b] = random8(3) - 1;
-                        }
+        if (Audio.snare.hit)
+        {
+            spawnBlob(Audio.snare.band, Audio.snare.strength >> 1);
+        }
 
-                        blob_size[b] = 2 + (Audio.heights8[audio_index] >> 5);
-                        blob_hue[b] = base_hue + (audio_index << 2);
-                        blob_life[b] = 255;
-                        break;
-                    }
-                }
-            }
+        if (Audio.hat.hit)
+        {
+            spawnBlob(Audio.hat.band, Audio.hat.strength >> 2);
         }
 
         // Update and draw blobs
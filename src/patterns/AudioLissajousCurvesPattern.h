@@ -4,6 +4,9 @@
 
 class AudioLissajousCurvesPattern final : public Pattern
 {
+    // Quietest waveform peak the phase plot is scaled to
+    static constexpr int32_t SCOPE_MIN_PEAK = 1024;
+
     // Simple curve parameters
     uint8_t curve_points[128][2]; // x,y coordinates for curve points
     uint8_t point_count = 64;
@@ -19,6 +22,7 @@ class AudioLissajousCurvesPattern final : public Pattern
     uint8_t curve_thickness = 1;
     bool multiple_curves = false;
     bool trail_mode = true;
+    bool scope_mode = false; // plot the captured waveform against a delayed copy of itself
 
     void randomize()
     {
@@ -35,6 +39,7 @@ class AudioLissajousCurvesPattern final : public Pattern
         curve_thickness = random8(1, 3);
         multiple_curves = random8(3) == 0; // 33% chance
         trail_mode = random8(4) > 0;       // 75% chance
+        scope_mode = random8(3) == 0;      // 33% chance
     }
 
   public:
@@ -83,6 +88,12 @@ class AudioLissajousCurvesPattern final : public Pattern
         uint8_t current_amp_x = amplitude_x + (Audio.energy8 >> 4);
         uint8_t current_amp_y = amplitude_y + (Audio.energy8 >> 4);
 
+        // In scope mode a tone traces an ellipse, like a sine pair on an XY oscilloscope; the delay,
+        // in waveform samples, sets which frequencies come out round
+        const uint8_t scope_delay = 2 + 2 * y_frequency;
+        const bool scope = scope_mode && Audio.waveform.size() > point_count + scope_delay;
+        const int32_t scope_peak = scope ? Audio.waveformPeak(point_count + scope_delay, SCOPE_MIN_PEAK) : 1;
+
         // Calculate curve points
         for (uint8_t i = 0; i < point_count; i++)
         {
@@ -92,6 +103,13 @@ class AudioLissajousCurvesPattern final : public Pattern
             uint8_t x_val = sin8((current_x_freq * t) + x_phase);
             uint8_t y_val = sin8((current_y_freq * t) + y_phase);
 
+            int16_t x_sample, y_sample;
+            if (scope && Audio.waveform.read(i, x_sample) && Audio.waveform.read(i + scope_delay, y_sample))
+            {
+                x_val = 128 + x_sample * 127 / scope_peak;
+                y_val = 128 + y_sample * 127 / scope_peak;
+            }
+
             // Scale and center
             curve_points[i][0] = MATRIX_CENTER_X + ((current_amp_x * (x_val - 128)) >> 7);
             curve_points[i][1] = MATRIX_CENTER_Y + ((current_amp_y * (y_val - 128)) >> 7);
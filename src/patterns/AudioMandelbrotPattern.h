@@ -9,11 +9,11 @@ class AudioMandelbrotPattern final : public Pattern
     uint8_t maxIterations = 20;
 
     // Rotation parameters
-    uint8_t rotationAngle = 0;
+    FrameCounter<uint8_t> rotationAngle = 0;
     uint8_t rotationSpeed = 1;
 
     // Visual parameters
-    uint8_t colorOffset = 0;
+    FrameCounter<uint8_t> colorOffset = 0;
     uint8_t colorSpeed = 2;
     bool kal12 = false;
 
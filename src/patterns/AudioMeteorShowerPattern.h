@@ -30,6 +30,26 @@ class AudioMeteorShowerPattern final : public Pattern
         trails = random8(2);
     }
 
+    void spawnMeteor(const uint16_t speed, const uint8_t minLen, const uint8_t maxLen)
+    {
+        // Find an inactive meteor to spawn
+        for (uint8_t i = 0; i < MAX_METEORS; ++i)
+        {
+            if (!meteor_active[i])
+            {
+                meteor_active[i] = true;
+                meteor_x[i] = random8(MATRIX_WIDTH);
+                // Start up to 16 pixels off-screen, using 8.8 fixed point
+                meteor_y_fixed[i] = -(int16_t)(random8(1, 16) << 8);
+                // Speed in pixels per frame (8.8 fixed point)
+                meteor_speed[i] = speed;
+                meteor_len[i] = random8(minLen, maxLen);
+                meteor_hue[i] = hue_offset + random8(64);
+                return;
+            }
+        }
+    }
+
   public:
     static constexpr auto ID = "Audio Meteor Shower";
 
@@ -62,36 +82,32 @@ class AudioMeteorShowerPattern final : public Pattern
 
         hue_offset++;
 
-        if (Audio.isBeat)
+        if (Audio.isBeat && Audio.totalBeats % 4 == 0)
         {
-            if (Audio.totalBeats % 4 == 0)
-            {
-                randomize();
-            }
+            randomize();
+        }
 
-            // Spawn a burst of meteors on beat
-            uint8_t meteorsToSpawn = 1 + (Audio.energy8 >> 4);
+        // Kicks drop a burst of long, heavy meteors; harder kicks drop more
+        if (Audio.kick.hit)
+        {
+            const uint8_t meteorsToSpawn = 1 + (Audio.kick.strength >> 5);
             for (uint8_t k = 0; k < meteorsToSpawn; ++k)
             {
-                // Find an inactive meteor to spawn
-                for (uint8_t i = 0; i < MAX_METEORS; ++i)
-                {
-                    if (!meteor_active[i])
-                    {
-                        meteor_active[i] = true;
-                        meteor_x[i] = random8(MATRIX_WIDTH);
-                        // Start up to 16 pixels off-screen, using 8.8 fixed point
-                        meteor_y_fixed[i] = -(int16_t)(random8(1, 16) << 8);
-                        // Speed in pixels per frame (8.8 fixed point)
-                        meteor_speed[i] = Audio.heights8[i]; // Slower to faster meteors
-                        meteor_len[i] = random8(5, 15);
-                        meteor_hue[i] = hue_offset + random8(64);
-                        break; // Found a slot, stop searching
-                    }
-                }
+                spawnMeteor(64 + Audio.kick.strength, 5, 15);
             }
         }
 
+        // Snares and hats add single, quicker streaks
+        if (Audio.snare.hit)
+        {
+            spawnMeteor(128 + Audio.snare.strength, 4, 10);
+        }
+
+        if (Audio.hat.hit)
+        {
+            spawnMeteor(256 + Audio.hat.strength, 2, 6);
+        }
+
         // update and draw meteors
         for (uint8_t i = 0; i < MAX_METEORS; ++i)
         {
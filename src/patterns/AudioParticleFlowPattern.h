@@ -21,7 +21,7 @@ class AudioParticleFlowPattern final : public Pattern
 
     // Flow field parameters
     uint8_t flowFieldScale = 16;
-    uint16_t flowFieldOffset = 0;
+    FrameCounter<uint16_t> flowFieldOffset = 0;
     uint8_t flowFieldSpeed = 1;
     uint8_t gravityStrength = 0;
     uint8_t attractorX = MATRIX_CENTER_X;
@@ -29,7 +29,7 @@ class AudioParticleFlowPattern final : public Pattern
     bool useAttractor = false;
 
     // Visual parameters
-    uint8_t baseHue = 0;
+    FrameCounter<uint8_t> baseHue = 0;
     uint8_t hueSpeed = 1;
     uint8_t fadeAmount = 235;
     uint8_t particleSize = 1;
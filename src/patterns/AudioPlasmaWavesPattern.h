@@ -9,8 +9,8 @@ class AudioPlasmaWavesPattern final : public Pattern
     uint8_t waveSpeed2 = 1;
     uint8_t waveScale1 = 20;
     uint8_t waveScale2 = 15;
-    uint16_t waveOffset1 = 0;
-    uint16_t waveOffset2 = 0;
+    FrameCounter<uint16_t> waveOffset1 = 0;
+    FrameCounter<uint16_t> waveOffset2 = 0;
 
     // Audio response
     uint8_t audioInfluence = 128;
@@ -18,7 +18,7 @@ class AudioPlasmaWavesPattern final : public Pattern
     uint8_t trebleBoost = 3;
 
     // Visual parameters
-    uint8_t colorShift = 0;
+    FrameCounter<uint8_t> colorShift = 0;
     uint8_t colorSpeed = 1;
     bool dualWaves = true;
     bool crossHatch = false;
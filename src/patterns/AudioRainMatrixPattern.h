@@ -27,6 +27,9 @@ class AudioRainMatrixPattern final : public Pattern
     uint8_t audioSensitivity = 6;
     uint8_t lastEnergyLevel = 0;
 
+    // Spectrogram rows the trails replay, newest first; trails are shorter than this
+    std::array<std::array<uint8_t, BINS>, 16> trailLevels;
+
     void randomize()
     {
         // Randomize initial parameters
@@ -76,6 +79,11 @@ class AudioRainMatrixPattern final : public Pattern
         uint8_t energyDiff = (currentEnergy > lastEnergyLevel) ? currentEnergy - lastEnergyLevel : 0;
         lastEnergyLevel = currentEnergy;
 
+        // Trails replay each band's recent levels, one analysis frame per trail step
+        size_t history = 0;
+        while (history < trailLevels.size() && Audio.spectrogram.read(history, trailLevels[history]))
+            history++;
+
         // Update each column
         for (uint8_t x = 0; x < MATRIX_WIDTH; x++)
         {
@@ -125,6 +133,8 @@ class AudioRainMatrixPattern final : public Pattern
                     {
                         uint8_t brightness = 255 - (i * 255 / columnLength[x]);
                         brightness = brightness >> 1; // Make trail dimmer
+                        if (i < history)
+                            brightness = scale8(brightness, 96 + scale8(trailLevels[i][x], 159));
                         CRGB trailColor = ColorFromPalette(palette, columnHue[x] + (i << 2), brightness);
                         Gfx.drawPixel(x, trailY, trailColor);
                     }
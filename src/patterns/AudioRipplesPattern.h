@@ -17,7 +17,6 @@ class AudioRipplesPattern final : public Pattern
     uint8_t fadeAmount = 240;
     uint8_t colorOffset = 0;
     uint8_t colorSpeed = 2;
-    uint8_t audioSensitivity = 8;
     uint8_t rippleThickness = 2;
 
     // Effects
@@ -29,7 +28,6 @@ class AudioRipplesPattern final : public Pattern
     {
         fadeAmount = random8(220, 250);
         colorSpeed = random8(1, 3);
-        audioSensitivity = random8(6, 10);
         rippleThickness = random8(1, 4);
         useKaleidoscope = random8(2);
         kaleidoscopeMode = random8(1, KALEIDOSCOPE_COUNT + 1);
@@ -46,6 +44,24 @@ class AudioRipplesPattern final : public Pattern
         rippleActive[index] = true;
     }
 
+    // Starts a ripple across from the band the hit rose in, higher up for stronger hits
+    void startRipple(const PercussiveEvent &event, const uint8_t hueShift)
+    {
+        for (uint8_t i = 0; i < MAX_RIPPLES; i++)
+        {
+            if (!rippleActive[i])
+            {
+                rippleX[i] = event.band * MATRIX_WIDTH / BINS;
+                rippleY[i] = event.strength >> 3;
+                rippleRadius[i] = 0;
+                rippleHue[i] = colorOffset + hueShift;
+                rippleSpeed[i] = 1 + (Audio.energy8 >> 6);
+                rippleActive[i] = true;
+                return;
+            }
+        }
+    }
+
   public:
     static constexpr auto ID = "Audio Ripples";
 
@@ -93,22 +109,20 @@ class AudioRipplesPattern final : public Pattern
         // Update color cycling
         colorOffset += colorSpeed;
 
-        // Start ripples based on audio peaks
-        for (uint8_t i = 0; i < MAX_RIPPLES; i++)
+        // Start ripples on percussive hits
+        if (Audio.kick.hit)
         {
-            if (!rippleActive[i])
-            {
-                uint8_t audioIndex = i * (BINS / MAX_RIPPLES);
-                if (Audio.heights8[audioIndex] > (255 / audioSensitivity))
-                {
-                    rippleX[i] = map8(audioIndex, 0, MATRIX_WIDTH - 1);
-                    rippleY[i] = Audio.heights8[audioIndex] >> 3;
-                    rippleRadius[i] = 0;
-                    rippleHue[i] = colorOffset + (i * 42);
-                    rippleSpeed[i] = 1 + (Audio.energy8 >> 6);
-                    rippleActive[i] = true;
-                }
-            }
+            startRipple(Audio.kick, 0);
+        }
+
+        if (Audio.snare.hit)
+        {
+            startRipple(Audio.snare, 84);
+        }
+
+        if (Audio.hat.hit)
+        {
+            startRipple(Audio.hat, 168);
         }
 
         // Draw and update ripples
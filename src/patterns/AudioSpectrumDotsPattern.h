@@ -4,9 +4,9 @@
 
 class AudioSpectrumDotsPattern final : public Pattern
 {
-    uint8_t rotation = 0;
+    FrameCounter<uint8_t> rotation = 0;
     uint8_t rotationSpeed = 2;
-    uint8_t colorOffset = 0;
+    FrameCounter<uint8_t> colorOffset = 0;
     uint8_t baseRadius = 8;
     bool pulseMode = false;
 
@@ -20,8 +20,8 @@ class AudioTessellationPattern final : public Pattern
     static constexpr uint8_t MAX_POLYGONS = 12;
     Polygon polygons[MAX_POLYGONS];
     uint8_t activePolygons = 8;
-    uint8_t globalRotation = 0;
-    uint8_t morphPhase = 0;
+    FrameCounter<uint8_t> globalRotation = 0;
+    FrameCounter<uint8_t> morphPhase = 0;
     uint8_t tessellationGrid = 8;
     bool morphMode = false;
     uint8_t rotationSpeed = 2;
@@ -18,7 +18,7 @@ class AudioWaveInterferencePattern final : public Pattern
     static constexpr uint8_t MAX_SOURCES = 6;
     WaveSource sources[MAX_SOURCES];
     uint8_t activeSourceCount = 4;
-    uint8_t globalPhase = 0;
+    FrameCounter<uint8_t> globalPhase = 0;
     uint8_t interferenceThreshold = 80;
     uint8_t waveSpeed = 3;
     bool constructiveMode = true;
@@ -4,8 +4,12 @@
 
 class AudioWaveformPattern final : public Pattern
 {
+    // Quietest waveform peak the trace is scaled to, so silence stays flat instead of amplified noise
+    static constexpr int32_t SCOPE_MIN_PEAK = 1024;
+
     // Simple waveform parameters
     uint8_t wave_points[64][2]; // x,y coordinates for wave points
+    uint8_t scope_values[64];   // captured waveform per point, 0-255 around 128 like sin8
     uint8_t point_count = 48;
     uint8_t base_hue = 0;
     uint8_t hue_speed = 2;
@@ -18,6 +22,25 @@ class AudioWaveformPattern final : public Pattern
     bool multiple_waves = false;
     bool vertical_mode = false;
 
+    // Samples the captured waveform, `stride` samples per point and newest on the right.
+    // Returns false while there is not enough history yet, or if the analyzer overwrote it meanwhile.
+    bool loadScope(const uint8_t stride)
+    {
+        const size_t span = std::min<size_t>(stride, Audio.waveform.size() / point_count);
+        if (span == 0)
+            return false;
+
+        const int32_t peak = Audio.waveformPeak(span * point_count, SCOPE_MIN_PEAK);
+        for (uint8_t i = 0; i < point_count; i++)
+        {
+            int16_t sample;
+            if (!Audio.waveform.read((point_count - 1 - i) * span, sample))
+                return false;
+            scope_values[i] = static_cast<uint8_t>(128 + sample * 127 / peak);
+        }
+        return true;
+    }
+
   public:
     static constexpr auto ID = "Audio Waveform";
 
@@ -61,6 +84,9 @@ class AudioWaveformPattern final : public Pattern
         uint8_t audio_amplitude = wave_amplitude + (Audio.energy8 >> 3);
         uint8_t audio_frequency = wave_frequency + (Audio.avgHeights8Range(16, 47) >> 5);
 
+        // Trace the captured waveform; the synthetic wave stands in until there is enough of it
+        const bool scope = loadScope(audio_frequency);
+
         // Calculate wave points
         if (vertical_mode)
         {
@@ -69,7 +95,7 @@ class AudioWaveformPattern final : public Pattern
             {
                 uint8_t y = (i * MATRIX_HEIGHT) / point_count;
                 uint8_t wave_input = (y * audio_frequency) + wave_phase;
-                uint8_t wave_val = sin8(wave_input);
+                uint8_t wave_val = scope ? scope_values[i] : sin8(wave_input);
                 
                 uint8_t x = MATRIX_CENTER_X + ((audio_amplitude * (wave_val - 128)) >> 7);
                 
@@ -92,7 +118,7 @@ class AudioWaveformPattern final : public Pattern
             {
                 uint8_t x = (i * MATRIX_WIDTH) / point_count;
                 uint8_t wave_input = (x * audio_frequency) + wave_phase;
-                uint8_t wave_val = sin8(wave_input);
+                uint8_t wave_val = scope ? scope_values[i] : sin8(wave_input);
                 
                 uint8_t y = MATRIX_CENTER_Y + ((audio_amplitude * (wave_val - 128)) >> 7);
                 
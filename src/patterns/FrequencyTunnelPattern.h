@@ -102,7 +102,7 @@ class FrequencyTunnelPattern final : public Pattern
         }
 
         // Bass response for tunnel zoom
-        bassZoom = (Audio.peaks8[0] + Audio.peaks8[1] + Audio.peaks8[2]) / 12;
+        bassZoom = Audio.sumPeaks8Range(0, 3) / 12;
 
         // Draw tunnel rings from back to front
         for (uint8_t ring = ringCount; ring > 0; ring--)
@@ -24,6 +24,27 @@ class MusicPlaylist final : public Pattern
     uint8_t nextPatternWait = waits[random8(0, waits.size())];
     uint8_t nextBackgroundWait = waits[random8(0, waits.size())];
     uint8_t nextForegroundWait = waits[random8(0, waits.size())];
+    uint32_t beatCount = 0;
+    uint32_t lastClockBeats = 0;
+
+    // Once the tempo tracker locks, beats come from its clock extrapolated to now, so switches
+    // land on the beat itself rather than one analysis latency after it
+    bool onBeat()
+    {
+        if (!Audio.tempoLocked())
+        {
+            return Audio.isBeat;
+        }
+
+        const uint32_t clockBeats = Audio.clockBeatsAt(micros());
+        if (static_cast<int32_t>(clockBeats - lastClockBeats) <= 0)
+        {
+            return false;
+        }
+
+        lastClockBeats = clockBeats;
+        return true;
+    }
 
     void nextBackground()
     {
@@ -125,23 +146,25 @@ class MusicPlaylist final : public Pattern
 
     void render() override
     {
-        if (Audio.isBeat)
+        if (onBeat())
         {
-            if (Audio.totalBeats % nextPatternWait == 0)
+            beatCount++;
+
+            if (beatCount % nextPatternWait == 0)
             {
                 nextPatternWait = waits[random8(0, waits.size())];
                 nextPattern();
             }
 
-            if (Audio.totalBeats % nextBackgroundWait == 0)
+            if (beatCount % nextBackgroundWait == 0)
             {
                 nextBackgroundWait = waits[random8(0, waits.size())];
                 nextBackground();
             }
         }
 
-        currBkg->render();
-        currBkg->backgroundPostProcess();
-        currPtn->render();
+        currBkg->profiledRender();
+        currBkg->profiledBackgroundPostProcess();
+        currPtn->profiledRender();
     }
 };
@@ -0,0 +1,61 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdio>
+#include <unity.h>
+
+// Shared helpers for the host tests and benchmarks, run with `pio test -e native`. Timings are host
+// numbers: they rank implementations against each other but do not predict ESP32 cycle counts.
+
+// Direct O(N^2) DFT in double precision, the reference every transform is checked against
+inline void referenceDft(const std::complex<double> *in, std::complex<double> *out, const size_t n)
+{
+    for (size_t k = 0; k < n; ++k)
+    {
+        std::complex<double> sum = 0.0;
+        for (size_t t = 0; t < n; ++t)
+        {
+            const double angle = -2.0 * M_PI * static_cast<double>(k * t % n) / static_cast<double>(n);
+            sum += in[t] * std::polar(1.0, angle);
+        }
+        out[k] = sum;
+    }
+}
+
+// Keeps the optimizer from discarding the work behind `value`
+template <typename T>
+void keepAlive(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Nanoseconds per call of `fn`, the best of `rounds` runs of `iterations` calls each. The best run is
+// the one least disturbed by the host scheduler.
+template <typename TFn>
+double nsPerCall(TFn &&fn, const size_t iterations, const size_t rounds = 5)
+{
+    double best = INFINITY;
+    for (size_t r = 0; r < rounds; ++r)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            fn();
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / static_cast<double>(iterations));
+    }
+    return best;
+}
+
+// Prints one benchmark line through the test output
+inline void reportBench(const char *name, const double value, const char *unit)
+{
+    char line[128];
+    std::snprintf(line, sizeof(line), "%-40s %10.1f %s", name, value, unit);
+    TEST_MESSAGE(line);
+}
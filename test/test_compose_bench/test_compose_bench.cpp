@@ -0,0 +1,192 @@
+﻿#include <array>
+#include <functional>
+#include <random>
+#include <unity.h>
+
+#include "../support/HostBench.h"
+#include "PanelLayout.h"
+#include "SmartArray.h"
+#include "Util.h"
+
+// The fused driver-order compose/remap/gamma sweep against the path it replaced: the render loop
+// summed both layers into a canvas-order frame through bounds-checked SmartArray lookups, and the
+// present thread rotated every pixel into place on its way to the driver. Both paths are timed for
+// comparison only; the sweep reads the canvas out of order for rotated layouts and is not expected
+// to be faster.
+
+// Stand-in for CRGB: three bytes with a per-channel saturating add
+struct Pixel
+{
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+
+    friend Pixel operator+(const Pixel &lhs, const Pixel &rhs)
+    {
+        return {static_cast<uint8_t>(std::min(lhs.r + rhs.r, 255)), static_cast<uint8_t>(std::min(lhs.g + rhs.g, 255)),
+                static_cast<uint8_t>(std::min(lhs.b + rhs.b, 255))};
+    }
+
+    bool operator==(const Pixel &) const = default;
+};
+
+static constexpr PanelLayout LAYOUT{PanelRotation::ROTATE_90};
+using Remap = PanelRemap<PANEL_WIDTH, PANEL_HEIGHT, PANELS_NUMBER, LAYOUT>;
+static_assert(Remap::CANVAS_WIDTH == MATRIX_WIDTH && Remap::CANVAS_HEIGHT == MATRIX_HEIGHT);
+
+using Canvas = SmartArray<Pixel, MATRIX_WIDTH, MATRIX_HEIGHT>;
+
+static constexpr std::array<size_t, 256> GAMMA = GenGammaTable<2.2f, 256, 255>();
+
+static constexpr size_t ITERATIONS = 2000;
+static constexpr size_t ROUNDS = 20;
+
+// Stand-in for drawPixelRGB888: an out-of-line call that stores into the driver's buffer
+static std::array<Pixel, Remap::PIXELS> driver;
+
+[[gnu::noinline]] static void drawPixel(const int16_t x, const int16_t y, const uint8_t r, const uint8_t g,
+                                        const uint8_t b)
+{
+    driver[y * Remap::DRIVER_WIDTH + x] = {r, g, b};
+}
+
+static void fillRandom(Canvas &canvas, std::mt19937 &rng)
+{
+    std::uniform_int_distribution<int> channel(0, 255);
+    for (size_t y = 0; y < MATRIX_HEIGHT; ++y)
+    {
+        for (size_t x = 0; x < MATRIX_WIDTH; ++x)
+        {
+            canvas(x, y) = {static_cast<uint8_t>(channel(rng)), static_cast<uint8_t>(channel(rng)),
+                            static_cast<uint8_t>(channel(rng))};
+        }
+    }
+}
+
+// The old render-side compose, canvas order
+static void composeCanvas(Canvas &layer, Canvas &background, std::array<Pixel, MATRIX_SIZE> &frame)
+{
+    for (int16_t y = 0; y < MATRIX_HEIGHT; ++y)
+    {
+        for (int16_t x = 0; x < MATRIX_WIDTH; ++x)
+        {
+            frame[y * MATRIX_WIDTH + x] = layer(x, y) + background(x, y);
+        }
+    }
+}
+
+// The old present sweep, rotating 90 degrees clockwise per pixel
+static void presentRotated(const std::array<Pixel, MATRIX_SIZE> &frame)
+{
+    for (int16_t y = 0; y < static_cast<int16_t>(Remap::DRIVER_HEIGHT); ++y)
+    {
+        for (int16_t x = 0; x < static_cast<int16_t>(Remap::DRIVER_WIDTH); ++x)
+        {
+            const int16_t gfx_x = y;
+            const int16_t gfx_y = MATRIX_WIDTH - 1 - x;
+            const Pixel &led = frame[gfx_y * MATRIX_WIDTH + gfx_x];
+            drawPixel(x, y, led.r, led.g, led.b);
+        }
+    }
+}
+
+// The new present sweep, driver order with no coordinate math
+static void presentLinear(const std::array<Pixel, Remap::PIXELS> &frame)
+{
+    const Pixel *led = frame.data();
+    for (size_t y = 0; y < Remap::DRIVER_HEIGHT; ++y)
+    {
+        for (size_t x = 0; x < Remap::DRIVER_WIDTH; ++x, ++led)
+        {
+            drawPixel(static_cast<int16_t>(x), static_cast<int16_t>(y), led->r, led->g, led->b);
+        }
+    }
+}
+
+static void test_matches_per_pixel_path()
+{
+    std::mt19937 rng(1);
+    static Canvas layer;
+    static Canvas background;
+    fillRandom(layer, rng);
+    fillRandom(background, rng);
+
+    static std::array<Pixel, MATRIX_SIZE> canvasFrame;
+    composeCanvas(layer, background, canvasFrame);
+    presentRotated(canvasFrame);
+    const auto expected = driver;
+
+    static std::array<Pixel, Remap::PIXELS> frame;
+    Remap::compose(layer.elements(), background.elements(), frame.data());
+    presentLinear(frame);
+    TEST_ASSERT_TRUE(frame == expected);
+    TEST_ASSERT_TRUE(driver == expected);
+
+    Remap::compose(layer.elements(), background.elements(), frame.data(), GAMMA);
+    for (size_t i = 0; i < Remap::PIXELS; ++i)
+    {
+        TEST_ASSERT_TRUE(frame[i].r == GAMMA[expected[i].r] && frame[i].g == GAMMA[expected[i].g] &&
+                         frame[i].b == GAMMA[expected[i].b]);
+    }
+}
+
+static void test_benchmark()
+{
+    std::mt19937 rng(2);
+    static Canvas layer;
+    static Canvas background;
+    fillRandom(layer, rng);
+    fillRandom(background, rng);
+
+    static std::array<Pixel, MATRIX_SIZE> canvasFrame;
+    static std::array<Pixel, Remap::PIXELS> frame;
+
+    const double composeOld = nsPerCall(
+        [&]
+        {
+            composeCanvas(layer, background, canvasFrame);
+            keepAlive(canvasFrame);
+        },
+        ITERATIONS, ROUNDS);
+    const double presentOld = nsPerCall([&] { presentRotated(canvasFrame); }, ITERATIONS, ROUNDS);
+    const double composeNew = nsPerCall(
+        [&]
+        {
+            Remap::compose(layer.elements(), background.elements(), frame.data());
+            keepAlive(frame);
+        },
+        ITERATIONS, ROUNDS);
+    const double composeGamma = nsPerCall(
+        [&]
+        {
+            Remap::compose(layer.elements(), background.elements(), frame.data(), GAMMA);
+            keepAlive(frame);
+        },
+        ITERATIONS, ROUNDS);
+    const double presentNew = nsPerCall([&] { presentLinear(frame); }, ITERATIONS, ROUNDS);
+
+    reportBench("old compose, SmartArray lookups", composeOld / 1000.0, "us per frame");
+    reportBench("old present, rotated per pixel", presentOld / 1000.0, "us per frame");
+    reportBench("old total", (composeOld + presentOld) / 1000.0, "us per frame");
+    reportBench("fused compose sweep", composeNew / 1000.0, "us per frame");
+    reportBench("fused compose sweep with gamma", composeGamma / 1000.0, "us per frame");
+    reportBench("present, driver order", presentNew / 1000.0, "us per frame");
+    reportBench("new total", (composeNew + presentNew) / 1000.0, "us per frame");
+    keepAlive(driver);
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_per_pixel_path);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,187 @@
+﻿#include <array>
+#include <random>
+#include <unity.h>
+#include <vector>
+
+#include "../support/HostBench.h"
+#include "FFT.h"
+
+// The recursive transform FFT<N> replaced: a fresh scratch vector per call and a sin/cos pair per
+// butterfly. Kept here as the benchmark baseline.
+static void recursiveFftImpl(std::complex<float> *x, const size_t n, std::complex<float> *scratch)
+{
+    if (n <= 1)
+        return;
+
+    std::complex<float> *even = scratch;
+    std::complex<float> *odd = scratch + n / 2;
+    for (size_t i = 0; i < n / 2; i++)
+    {
+        even[i] = x[2 * i];
+        odd[i] = x[2 * i + 1];
+    }
+
+    recursiveFftImpl(even, n / 2, x);
+    recursiveFftImpl(odd, n / 2, x + n / 2);
+
+    for (size_t k = 0; k < n / 2; k++)
+    {
+        const float angle = -2.0f * M_PI * static_cast<float>(k) / static_cast<float>(n);
+        const std::complex<float> t = std::polar(1.0f, angle) * odd[k];
+        x[k] = even[k] + t;
+        x[k + n / 2] = even[k] - t;
+    }
+}
+
+static void recursiveFft(std::vector<std::complex<float>> &x)
+{
+    std::vector<std::complex<float>> scratch(x.size());
+    recursiveFftImpl(x.data(), x.size(), scratch.data());
+}
+
+// Largest error against the reference DFT, relative to the largest reference bin
+template <size_t N>
+static double complexError(const std::array<std::complex<float>, N> &input, const std::complex<float> *output)
+{
+    std::array<std::complex<double>, N> in{};
+    std::array<std::complex<double>, N> expected{};
+    std::copy(input.begin(), input.end(), in.begin());
+    referenceDft(in.data(), expected.data(), N);
+
+    double peak = 0.0;
+    double error = 0.0;
+    for (size_t k = 0; k < N; ++k)
+    {
+        peak = std::max(peak, std::abs(expected[k]));
+        error = std::max(error, std::abs(expected[k] - std::complex<double>(output[k])));
+    }
+    return error / peak;
+}
+
+template <size_t N>
+static std::array<std::complex<float>, N> randomSignal(const uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::array<std::complex<float>, N> signal{};
+    for (auto &x : signal)
+    {
+        x = {dist(rng), dist(rng)};
+    }
+    return signal;
+}
+
+template <size_t N>
+static void checkComplexFft()
+{
+    const auto input = randomSignal<N>(N);
+    auto output = input;
+    FFT<N>::transform(output.data());
+    TEST_ASSERT_TRUE(complexError<N>(input, output.data()) < 1e-5);
+}
+
+static void test_complex_fft_matches_dft()
+{
+    checkComplexFft<8>();
+    checkComplexFft<64>();
+    checkComplexFft<256>();
+    checkComplexFft<512>();
+}
+
+template <size_t N>
+static void checkRealFft()
+{
+    std::mt19937 rng(N);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    std::array<std::complex<float>, N> input{};
+    std::array<std::complex<float>, RealFFT<N>::BUFFER_SIZE> buffer{};
+    float *samples = RealFFT<N>::samples(buffer.data());
+    for (size_t i = 0; i < N; ++i)
+    {
+        samples[i] = dist(rng);
+        input[i] = samples[i];
+    }
+
+    RealFFT<N>::transform(buffer.data());
+
+    // The real transform only writes DC through Nyquist; the rest is the conjugate mirror
+    std::array<std::complex<float>, N> output{};
+    for (size_t k = 0; k < RealFFT<N>::SPECTRUM_SIZE; ++k)
+    {
+        output[k] = buffer[k];
+        output[(N - k) % N] = std::conj(buffer[k]);
+    }
+    TEST_ASSERT_TRUE(complexError<N>(input, output.data()) < 1e-5);
+}
+
+static void test_real_fft_matches_dft()
+{
+    checkRealFft<8>();
+    checkRealFft<64>();
+    checkRealFft<256>();
+    checkRealFft<512>();
+}
+
+static void test_benchmark_against_recursive()
+{
+    constexpr size_t N = 512;
+    constexpr size_t ITERATIONS = 2000;
+    const auto input = randomSignal<N>(1);
+
+    // Every call starts from a fresh copy, so repeated in-place transforms do not overflow
+    std::vector<std::complex<float>> recursive(N);
+    const double recursiveNs = nsPerCall(
+        [&]
+        {
+            std::copy(input.begin(), input.end(), recursive.begin());
+            recursiveFft(recursive);
+            keepAlive(recursive);
+        },
+        ITERATIONS);
+
+    std::array<std::complex<float>, N> iterative{};
+    const double iterativeNs = nsPerCall(
+        [&]
+        {
+            iterative = input;
+            FFT<N>::transform(iterative.data());
+            keepAlive(iterative);
+        },
+        ITERATIONS);
+
+    // N real samples packed into N / 2 complex values
+    std::array<std::complex<float>, RealFFT<N>::BUFFER_SIZE> real{};
+    const double realNs = nsPerCall(
+        [&]
+        {
+            std::copy(input.begin(), input.begin() + N / 2, real.begin());
+            RealFFT<N>::transform(real.data());
+            keepAlive(real);
+        },
+        ITERATIONS);
+
+    reportBench("recursive FFT, 512 complex", recursiveNs / 1000.0, "us");
+    reportBench("FFT<512>", iterativeNs / 1000.0, "us");
+    reportBench("RealFFT<512>", realNs / 1000.0, "us");
+
+    TEST_ASSERT_TRUE(iterativeNs < recursiveNs);
+    TEST_ASSERT_TRUE(realNs < iterativeNs);
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_complex_fft_matches_dft);
+    RUN_TEST(test_real_fft_matches_dft);
+    RUN_TEST(test_benchmark_against_recursive);
+    return UNITY_END();
+}
@@ -0,0 +1,156 @@
+﻿#include <array>
+#include <random>
+#include <unity.h>
+
+#include "SpectrumEngine.h"
+
+// FixedSpectrumEngine must stay interchangeable with FloatSpectrumEngine: every bin of the Q15 path is
+// checked against the float path for tones, noise and full-scale input, in every window. The block
+// floating point FFT keeps its error relative to the loudest bin, so bins are compared as linear
+// magnitudes against a bound that scales with the frame's peak, over a floor set by 16-bit input.
+
+static constexpr size_t N = 512;
+static constexpr size_t BINS_OUT = N / 2 + 1;
+static constexpr float SAMPLE_RATE = 22050.0f;
+
+// Magnitude error allowed in any bin: MAX_RELATIVE_ERROR of the frame's peak (-60 dB) plus
+// MAX_ABSOLUTE_ERROR. The loudest bin's level must match within MAX_PEAK_LEVEL_ERROR.
+static constexpr float MAX_RELATIVE_ERROR = 1e-3f;
+static constexpr float MAX_ABSOLUTE_ERROR = 0.02f;
+static constexpr float MAX_PEAK_LEVEL_ERROR = 0.01f;
+
+using Samples = std::array<int32_t, N>;
+
+// 16-bit samples in the top half of 32-bit I2S words, as the microphone delivers them
+static int32_t toWord(const float value)
+{
+    return static_cast<int32_t>(std::lround(std::clamp(value, -1.0f, 32767.0f / 32768.0f) * 32768.0f)) * 65536;
+}
+
+static Samples tone(const float hz, const float amplitude, const float noise, const uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> dist;
+    Samples samples{};
+    for (size_t i = 0; i < N; ++i)
+    {
+        const float phase = 2.0f * static_cast<float>(M_PI) * hz * static_cast<float>(i) / SAMPLE_RATE;
+        samples[i] = toWord(amplitude * std::sin(phase) + noise * dist(rng));
+    }
+    return samples;
+}
+
+// Inverts level = log(1 + 3 m) / log(4)
+static float magnitude(const float level)
+{
+    return (std::exp(level * std::log(1.0f + SPECTRUM_LOG_SCALE_BASE)) - 1.0f) / SPECTRUM_LOG_SCALE_BASE;
+}
+
+static void checkAgainstFloat(const Samples &samples, const char *name)
+{
+    static FloatSpectrumEngine<N> reference;
+    static FixedSpectrumEngine<N> fixed;
+
+    for (size_t w = 0; w < WINDOW_TYPE_COUNT; ++w)
+    {
+        const auto window = static_cast<WindowType>(w);
+        std::array<float, BINS_OUT> expected{};
+        std::array<float, BINS_OUT> actual{};
+        reference.process(window, samples.data(), expected.data(), BINS_OUT);
+        fixed.process(window, samples.data(), actual.data(), BINS_OUT);
+
+        const size_t peak = std::max_element(expected.begin(), expected.end()) - expected.begin();
+        const float bound = MAX_RELATIVE_ERROR * magnitude(expected[peak]) + MAX_ABSOLUTE_ERROR;
+
+        char message[96];
+        for (size_t k = 0; k < BINS_OUT; ++k)
+        {
+            std::snprintf(message, sizeof(message), "%s, %s window, bin %zu", name, windowTypeName(window), k);
+            TEST_ASSERT_FLOAT_WITHIN_MESSAGE(bound, magnitude(expected[k]), magnitude(actual[k]), message);
+        }
+
+        std::snprintf(message, sizeof(message), "%s, %s window, peak bin", name, windowTypeName(window));
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(MAX_PEAK_LEVEL_ERROR, expected[peak], actual[peak], message);
+    }
+}
+
+static void test_tones()
+{
+    for (const float hz : {60.0f, 440.0f, 3000.0f, 9000.0f})
+    {
+        for (const float amplitude : {0.001f, 0.01f, 0.1f, 0.5f, 1.0f})
+        {
+            char name[48];
+            std::snprintf(name, sizeof(name), "%.0f Hz at %.3f", hz, amplitude);
+            checkAgainstFloat(tone(hz, amplitude, 0.0005f, static_cast<uint32_t>(hz)), name);
+        }
+    }
+}
+
+static void test_noise()
+{
+    for (const float level : {0.001f, 0.05f, 0.3f})
+    {
+        checkAgainstFloat(tone(0.0f, 0.0f, level, 7), "noise");
+    }
+}
+
+// Full-scale square waves and DC drive every FFT stage into the headroom checks
+static void test_full_scale()
+{
+    Samples square{};
+    for (size_t i = 0; i < N; ++i)
+    {
+        square[i] = toWord((i / 25) % 2 ? 1.0f : -1.0f);
+    }
+    checkAgainstFloat(square, "full-scale square");
+
+    Samples dc{};
+    dc.fill(toWord(1.0f));
+    checkAgainstFloat(dc, "full-scale DC");
+}
+
+// A butterfly whose inputs are all within MAX_SAFE must not saturate: |a| + |w b| with every component
+// at MAX_SAFE, over every twiddle, rounded the way FFTQ15 rounds
+static void test_headroom_fits_a_butterfly()
+{
+    constexpr int32_t limit = FFTQ15<N / 2>::MAX_SAFE;
+    int32_t worst = 0;
+    for (const cq15_t &w : FFTQ15<N / 2>::TWIDDLES)
+    {
+        for (const int32_t sr : {-limit, limit})
+        {
+            for (const int32_t si : {-limit, limit})
+            {
+                const int32_t tr = (w.re * sr - w.im * si + (1 << 14)) >> 15;
+                const int32_t ti = (w.re * si + w.im * sr + (1 << 14)) >> 15;
+                worst = std::max({worst, limit + std::abs(tr), limit + std::abs(ti)});
+            }
+        }
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_INT32(32767, worst);
+
+    // One more unit of headroom would overflow, so the constant is as large as it can be
+    const auto &diagonal = FFTQ15<N / 2>::TWIDDLES[N / 16];
+    const int32_t next = limit + 1;
+    const int32_t tr = (diagonal.re * next - diagonal.im * next + (1 << 14)) >> 15;
+    TEST_ASSERT_TRUE(next + std::abs(tr) > 32767);
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_tones);
+    RUN_TEST(test_noise);
+    RUN_TEST(test_full_scale);
+    RUN_TEST(test_headroom_fits_a_butterfly);
+    return UNITY_END();
+}
@@ -0,0 +1,140 @@
+﻿#include <array>
+#include <atomic>
+#include <thread>
+#include <unity.h>
+
+#include "TripleBuffer.h"
+
+// Frame large enough that a torn read would mix two publishes: every word carries the publish number
+struct Frame
+{
+    std::array<uint32_t, 256> words;
+};
+
+static constexpr uint32_t PUBLISHES = 2000000;
+static constexpr uint32_t YIELD_EVERY = 16;
+
+static void test_nothing_to_acquire_before_publish()
+{
+    TripleBuffer<Frame> buffer;
+    TEST_ASSERT_FALSE(buffer.acquire());
+    TEST_ASSERT_EQUAL_UINT32(0, buffer.frontSequence());
+
+    buffer.back().words.fill(1);
+    buffer.publish();
+    TEST_ASSERT_TRUE(buffer.acquire());
+    TEST_ASSERT_EQUAL_UINT32(1, buffer.frontSequence());
+    TEST_ASSERT_EQUAL_UINT32(1, buffer.front().words[0]);
+
+    // A publish is handed over once
+    TEST_ASSERT_FALSE(buffer.acquire());
+}
+
+static void test_newest_publish_wins()
+{
+    TripleBuffer<Frame> buffer;
+    for (uint32_t i = 1; i <= 5; ++i)
+    {
+        buffer.back().words.fill(i);
+        buffer.publish();
+    }
+
+    TEST_ASSERT_TRUE(buffer.acquire());
+    TEST_ASSERT_EQUAL_UINT32(5, buffer.frontSequence());
+    TEST_ASSERT_EQUAL_UINT32(5, buffer.front().words.back());
+}
+
+// Producer and consumer on their own threads, as MicFFT and the render loop are: every acquired frame
+// must be whole, match its sequence number, and be newer than the one before
+static void test_concurrent_producer_and_consumer()
+{
+    static TripleBuffer<Frame> buffer;
+    std::atomic<bool> done{false};
+
+    std::thread producer(
+        [&]
+        {
+            for (uint32_t i = 1; i <= PUBLISHES; ++i)
+            {
+                buffer.back().words.fill(i);
+                buffer.publish();
+
+                // Hand the core over now and then, so the sides interleave even on a single-core host
+                if (i % YIELD_EVERY == 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+            done.store(true, std::memory_order_release);
+        });
+
+    uint32_t acquired = 0;
+    uint32_t torn = 0;
+    uint32_t mismatched = 0;
+    uint32_t backwards = 0;
+    uint32_t last = 0;
+
+    const auto check = [&]
+    {
+        const Frame &frame = buffer.front();
+        const uint32_t sequence = buffer.frontSequence();
+        for (const uint32_t word : frame.words)
+        {
+            if (word != frame.words[0])
+            {
+                torn++;
+                break;
+            }
+        }
+        mismatched += frame.words[0] != sequence;
+        backwards += sequence <= last;
+        last = sequence;
+        acquired++;
+    };
+
+    while (!done.load(std::memory_order_acquire))
+    {
+        if (buffer.acquire())
+        {
+            check();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    // The last publish is never lost
+    if (buffer.acquire())
+    {
+        check();
+    }
+
+    char line[96];
+    std::snprintf(line, sizeof(line), "%u of %u publishes acquired", acquired, PUBLISHES);
+    TEST_MESSAGE(line);
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_EQUAL_UINT32(0, mismatched);
+    TEST_ASSERT_EQUAL_UINT32(0, backwards);
+    TEST_ASSERT_EQUAL_UINT32(PUBLISHES, last);
+    TEST_ASSERT_TRUE(acquired > 1);
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_nothing_to_acquire_before_publish);
+    RUN_TEST(test_newest_publish_wins);
+    RUN_TEST(test_concurrent_producer_and_consumer);
+    return UNITY_END();
+}